@@ -0,0 +1,409 @@
+/** scan_benchmark.cpp
+ *
+ * This program measures how quickly freud scans a process. It forks a
+ * synthetic target that fills a number of anonymous mappings with random
+ * bytes and plants structures of several sizes and alignments in them,
+ * then scans the target with `scan_once` and `scan_forever` (and with
+ * `scan_parallel`) for each kind of structure.
+ *
+ * Compile this program with
+ * 'g++ -O2 -I. benchmarks/scan_benchmark.cpp -o scan_benchmark -pthread'
+ *
+ * The resulting 'scan_benchmark' binary must be run as root (or with
+ * CAP_SYS_PTRACE). Options:
+ *
+ *   --heap-mb N     Megabytes of memory in the target (default 256)
+ *   --mappings N    Number of mappings the memory is split into (default 16)
+ *   --density N     Structures of each kind planted per megabyte (default 64)
+ *   --passes N      Passes made by scan_forever (default 3)
+ *   --threads N     Threads used by scan_parallel (default 4)
+ *   --window-kb N   Window size of the context, in KiB (default 16384)
+ *   --prefetch-depth N
+ *                   Windows read ahead by iterators (default 1)
+ *   --backend NAME  How target memory is read: 'vm' for process_vm_readv
+ *                   or 'procmem' for /proc/<pid>/mem (default vm)
+ *   --label TEXT    Included in every result, e.g. a commit hash
+ *
+ * Each result is written to standard output as one JSON object per line,
+ * so results from different commits can be compared with standard tools.
+ */
+
+#include "freud/freud.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <signal.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+struct Options {
+    std::size_t heap_mb;
+    std::size_t mappings;
+    std::size_t density;
+    std::size_t passes;
+    unsigned threads;
+    std::size_t window_kb;
+    std::size_t prefetch_depth;
+    freud::ReadBackend backend;
+    std::string label;
+};
+
+static const char* backend_name(freud::ReadBackend backend) {
+    return backend == freud::PROC_MEM_BACKEND ? "procmem" : "vm";
+}
+
+/// A structure of 'Size' bytes with the alignment of 'Word'. The first
+/// eight bytes hold a magic value unique to the Word and Size.
+template <typename Word, std::size_t Size>
+struct Planted {
+    Word words[Size / sizeof(Word)];
+};
+
+template <typename Word, std::size_t Size>
+uint64_t planted_magic() {
+    return 0x5eed000000000000ULL | (sizeof(Word) << 16) | Size;
+}
+
+/// The last byte of a planted structure, checked by verify
+const freud::byte_t planted_tail = 0xA5;
+
+static unsigned long verify_calls = 0;
+
+template <typename Word, std::size_t Size, bool Anchored>
+class PlantedMatcher : public freud::MemoryObject<Planted<Word, Size> > {
+public:
+    template <typename Context>
+    static bool verify(const Context&, const Planted<Word, Size>& p,
+                       freud::address_t) {
+        __sync_fetch_and_add(&verify_calls, 1);
+        const freud::byte_t* bytes =
+            reinterpret_cast<const freud::byte_t*>(&p);
+        uint64_t magic = planted_magic<Word, Size>();
+        return std::memcmp(bytes, &magic, sizeof(magic)) == 0 &&
+               bytes[Size - 1] == planted_tail;
+    }
+
+    static void anchors(std::vector<freud::Anchor>& out) {
+        if (Anchored) {
+            out.push_back(freud::make_anchor(0, planted_magic<Word, Size>()));
+        }
+    }
+};
+
+static uint64_t random_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t next_random() {
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+    return random_state;
+}
+
+template <typename Word, std::size_t Size>
+void plant(freud::byte_t* memory, std::size_t size, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::size_t offset = next_random() % (size - Size);
+        offset -= offset % sizeof(Word);
+        uint64_t magic = planted_magic<Word, Size>();
+        std::memcpy(memory + offset, &magic, sizeof(magic));
+        memory[offset + Size - 1] = planted_tail;
+    }
+}
+
+/// Fork a target process and wait until its memory is ready
+static pid_t spawn_target(const Options& options) {
+    int ready[2];
+    if (pipe(ready) != 0) {
+        return -1;
+    }
+    pid_t pid = fork();
+    if (pid != 0) {
+        char byte;
+        close(ready[1]);
+        if (pid < 0 || read(ready[0], &byte, 1) != 1) {
+            pid = -1;
+        }
+        close(ready[0]);
+        return pid;
+    }
+
+    close(ready[0]);
+    const std::size_t page = sysconf(_SC_PAGESIZE);
+    std::size_t size = options.heap_mb * 1024 * 1024 / options.mappings;
+    size = (size + page - 1) / page * page;
+    const std::size_t count = options.density * size / (1024 * 1024) + 1;
+    for (std::size_t m = 0; m < options.mappings; ++m) {
+        freud::byte_t* memory = static_cast<freud::byte_t*>(
+            mmap(NULL, size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (memory == MAP_FAILED) {
+            _exit(1);
+        }
+        for (std::size_t i = 0; i + sizeof(uint64_t) <= size;
+             i += sizeof(uint64_t)) {
+            uint64_t value = next_random();
+            std::memcpy(memory + i, &value, sizeof(value));
+        }
+        plant<uint64_t, 16>(memory, size, count);
+        plant<uint64_t, 64>(memory, size, count);
+        plant<uint64_t, 256>(memory, size, count);
+        plant<uint32_t, 64>(memory, size, count);
+        plant<uint8_t, 64>(memory, size, count);
+    }
+    if (write(ready[1], "", 1) != 1) {
+        _exit(1);
+    }
+    for (;;) {
+        pause();
+    }
+}
+
+static double now() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/// Reset the peak resident set size of this process (Linux 4.0+)
+static void reset_peak_rss() {
+    // Return memory freed by earlier runs, so it does not count again
+    malloc_trim(0);
+    FILE* file = std::fopen("/proc/self/clear_refs", "w");
+    if (file) {
+        std::fputs("5", file);
+        std::fclose(file);
+    }
+}
+
+/// The peak resident set size of this process in kilobytes
+static long peak_rss_kb() {
+    FILE* file = std::fopen("/proc/self/status", "r");
+    long result = -1;
+    char line[256];
+    while (file && std::fgets(line, sizeof(line), file)) {
+        if (std::sscanf(line, "VmHWM: %ld", &result) == 1) {
+            break;
+        }
+    }
+    if (file) {
+        std::fclose(file);
+    }
+    return result;
+}
+
+struct Result {
+    const char* method;
+    std::size_t struct_size;
+    std::size_t alignment;
+    bool anchors;
+    std::size_t bytes;
+    std::size_t matches;
+    double seconds;
+    double first_match_seconds;
+};
+
+static void report(const Options& options, const Result& result) {
+    double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+    std::printf("{\"label\":\"%s\",\"method\":\"%s\",\"struct_size\":%zu,"
+                "\"alignment\":%zu,\"anchors\":%s,\"heap_mb\":%zu,"
+                "\"mappings\":%zu,\"density\":%zu,\"window_kb\":%zu,"
+                "\"prefetch_depth\":%zu,\"backend\":\"%s\",\"bytes\":%zu,"
+                "\"matches\":%zu,\"seconds\":%.6f,\"bytes_per_sec\":%.0f,"
+                "\"verify_calls\":%lu,\"verify_per_sec\":%.0f,"
+                "\"first_match_seconds\":%.6f,\"peak_rss_kb\":%ld}\n",
+                options.label.c_str(), result.method, result.struct_size,
+                result.alignment, result.anchors ? "true" : "false",
+                options.heap_mb, options.mappings, options.density,
+                options.window_kb, options.prefetch_depth,
+                backend_name(options.backend), result.bytes,
+                result.matches, result.seconds,
+                result.bytes / seconds, verify_calls, verify_calls / seconds,
+                result.first_match_seconds, peak_rss_kb());
+    std::fflush(stdout);
+}
+
+static std::size_t context_bytes(const freud::MemoryContext& ctx) {
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < ctx.mapped_regions().size(); ++i) {
+        bytes += ctx.mapped_regions()[i].end_address -
+                 ctx.mapped_regions()[i].start_address;
+    }
+    return bytes;
+}
+
+struct CountMatches {
+    std::size_t* matches;
+
+    template <typename T>
+    void operator()(freud::address_t, const T&) {
+        ++*matches;
+    }
+};
+
+template <typename Matcher>
+void run(const Options& options, pid_t pid, Result result) {
+    typedef typename Matcher::type type;
+    result.struct_size = sizeof(type);
+    result.alignment = freud::detail::alignment_of<type>::value;
+
+    freud::MemoryContext ctx(pid, freud::RegionFilter::writable_data(),
+                             options.backend);
+    ctx.set_window_size(options.window_kb * 1024);
+    ctx.set_prefetch_depth(options.prefetch_depth);
+    const std::size_t bytes = context_bytes(ctx);
+
+    // scan_once: one pass over the target
+    reset_peak_rss();
+    verify_calls = 0;
+    result.method = "scan_once";
+    result.bytes = bytes;
+    result.matches = 0;
+    result.first_match_seconds = -1;
+    double start = now();
+    freud::MemoryContextIterator<Matcher> iter = ctx.scan_once<Matcher>();
+    for (; iter != ctx.end(); ++iter) {
+        if (result.matches++ == 0) {
+            result.first_match_seconds = now() - start;
+        }
+    }
+    result.seconds = now() - start;
+    report(options, result);
+
+    // scan_forever: a pass ends when the addresses start over
+    reset_peak_rss();
+    verify_calls = 0;
+    result.method = "scan_forever";
+    result.bytes = 0;
+    result.matches = 0;
+    result.first_match_seconds = -1;
+    start = now();
+    freud::MemoryContextIterator<Matcher> forever =
+        ctx.scan_forever<Matcher>();
+    freud::address_t previous = 0;
+    for (std::size_t passes = 0; forever != ctx.end(); ++forever) {
+        if (forever.address() <= previous &&
+            ++passes == options.passes) {
+            break;
+        }
+        if (result.matches++ == 0) {
+            result.first_match_seconds = now() - start;
+        }
+        previous = forever.address();
+    }
+    result.seconds = now() - start;
+    result.bytes = bytes * options.passes;
+    report(options, result);
+
+    // scan_parallel
+    reset_peak_rss();
+    verify_calls = 0;
+    result.method = "scan_parallel";
+    result.bytes = bytes;
+    result.matches = 0;
+    result.first_match_seconds = -1;
+    std::size_t matches = 0;
+    CountMatches callback = {&matches};
+    start = now();
+    ctx.scan_parallel<Matcher>(options.threads, callback);
+    result.seconds = now() - start;
+    result.matches = matches;
+    report(options, result);
+}
+
+static bool parse_options(int argc, char* argv[], Options& options) {
+    options.heap_mb = 256;
+    options.mappings = 16;
+    options.density = 64;
+    options.passes = 3;
+    options.threads = 4;
+    options.window_kb = 16 * 1024;
+    options.prefetch_depth = 1;
+    options.backend = freud::PROCESS_VM_READV_BACKEND;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string name = argv[i];
+        if (name == "--label") {
+            // Keep the output valid JSON
+            for (const char* c = argv[i + 1]; *c; ++c) {
+                if (*c == '"' || *c == '\\') {
+                    options.label += '\\';
+                }
+                if (static_cast<unsigned char>(*c) >= ' ') {
+                    options.label += *c;
+                }
+            }
+            continue;
+        }
+        if (name == "--backend") {
+            const std::string backend = argv[i + 1];
+            if (backend == "vm") {
+                options.backend = freud::PROCESS_VM_READV_BACKEND;
+            } else if (backend == "procmem") {
+                options.backend = freud::PROC_MEM_BACKEND;
+            } else {
+                return false;
+            }
+            continue;
+        }
+        std::size_t value = std::strtoul(argv[i + 1], NULL, 10);
+        if (name == "--heap-mb") {
+            options.heap_mb = value;
+        } else if (name == "--mappings") {
+            options.mappings = value;
+        } else if (name == "--density") {
+            options.density = value;
+        } else if (name == "--passes") {
+            options.passes = value;
+        } else if (name == "--threads") {
+            options.threads = value;
+        } else if (name == "--window-kb") {
+            options.window_kb = value;
+        } else if (name == "--prefetch-depth") {
+            options.prefetch_depth = value;
+        } else {
+            return false;
+        }
+    }
+    return argc % 2 == 1 && options.heap_mb > 0 && options.mappings > 0 &&
+           options.passes > 0 && options.threads > 0 &&
+           options.window_kb > 0 && options.prefetch_depth > 0;
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::fprintf(stderr, "usage: %s [--heap-mb N] [--mappings N] "
+                             "[--density N] [--passes N] [--threads N] "
+                             "[--window-kb N] [--prefetch-depth N] "
+                             "[--backend vm|procmem] [--label TEXT]\n",
+                     argv[0]);
+        return 1;
+    }
+
+    pid_t pid = spawn_target(options);
+    if (pid < 0) {
+        std::perror("fork");
+        return 1;
+    }
+
+    Result result;
+    std::memset(&result, 0, sizeof(result));
+    result.anchors = true;
+    run<PlantedMatcher<uint64_t, 16, true> >(options, pid, result);
+    run<PlantedMatcher<uint64_t, 64, true> >(options, pid, result);
+    run<PlantedMatcher<uint64_t, 256, true> >(options, pid, result);
+    run<PlantedMatcher<uint32_t, 64, true> >(options, pid, result);
+    run<PlantedMatcher<uint8_t, 64, true> >(options, pid, result);
+
+    result.anchors = false;
+    run<PlantedMatcher<uint64_t, 64, false> >(options, pid, result);
+    run<PlantedMatcher<uint8_t, 64, false> >(options, pid, result);
+
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    return 0;
+}
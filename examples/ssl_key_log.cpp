@@ -20,41 +20,68 @@
  */
 
 #include "freud/freud.hpp"
+#include <cstddef>
+#include <fstream>
 #include <iostream>
 #include <openssl/ssl.h>
-#include <set>
 #include <unistd.h>
 
 class SSL_SESSION_Matcher : public freud::MemoryObject<SSL_SESSION> {
 public:
-    static bool verify(const freud::MemoryContext& ctx, const SSL_SESSION& e,
-                       freud::address_t address) {
-        bool res = e.ssl_version == 0x303 && e.master_key_length == 48 &&
-                   e.session_id_length == 32;
-        return res;
+    static void anchors(std::vector<freud::Anchor>& out) {
+        out.push_back(
+            freud::make_anchor(offsetof(SSL_SESSION, ssl_version), 0x303));
+    }
+
+    static uint64_t verify_batch(const freud::MemoryContext&,
+                                 const freud::byte_t* data, freud::address_t,
+                                 const std::size_t* offsets,
+                                 std::size_t count) {
+        int version[freud::verify_batch_size];
+        int key_length[freud::verify_batch_size];
+        unsigned int id_length[freud::verify_batch_size];
+        freud::gather_field(data, offsets, count,
+                            offsetof(SSL_SESSION, ssl_version), version);
+        freud::gather_field(data, offsets, count,
+                            offsetof(SSL_SESSION, master_key_length),
+                            key_length);
+        freud::gather_field(data, offsets, count,
+                            offsetof(SSL_SESSION, session_id_length),
+                            id_length);
+        return freud::equal_mask(version, count, 0x303) &
+               freud::equal_mask(key_length, count, 48) &
+               freud::equal_mask(id_length, count, 32u);
+    }
+};
+
+// Logs each session when it first appears (or when its key changes)
+struct LogNewKeys {
+    std::ofstream* out;
+
+    void operator()(freud::MatchEvent event, freud::address_t,
+                    const SSL_SESSION* session) {
+        if (event == freud::MATCH_DISAPPEARED) {
+            return;
+        }
+        std::cout << "RSA Session-ID:"
+                  << freud::format_as_hex(session->session_id)
+                  << " Master-Key:" << freud::format_as_hex(session->master_key)
+                  << std::endl;
+
+        *out << "RSA Session-ID:" << freud::format_as_hex(session->session_id)
+             << " Master-Key:" << freud::format_as_hex(session->master_key)
+             << std::endl;
     }
 };
 
 int main(int argc, char** argv) {
     std::ofstream out("keys.log");
-    std::set<freud::address_t> known_matches;
+    LogNewKeys log = {&out};
 
     freud::MemoryContext ctx(atoi(argv[1]));
+    freud::MatchTracker<SSL_SESSION_Matcher> tracker;
 
-    freud::MemoryContextIterator<SSL_SESSION_Matcher> iter =
-        ctx.scan_forever<SSL_SESSION_Matcher>();
-
-    for (;; ++iter) {
-        if (!known_matches.count(iter.address())) {
-            std::cout << "RSA Session-ID:"
-                      << freud::format_as_hex(iter->session_id)
-                      << " Master-Key:"
-                      << freud::format_as_hex(iter->master_key) << std::endl;
-
-            out << "RSA Session-ID:" << freud::format_as_hex(iter->session_id)
-                << " Master-Key:" << freud::format_as_hex(iter->master_key)
-                << std::endl;
-            known_matches.insert(iter.address());
-        }
+    for (;;) {
+        tracker.scan(ctx, log);
     }
 }
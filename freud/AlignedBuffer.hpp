@@ -0,0 +1,118 @@
+#ifndef FREUD_ALIGNED_BUFFER
+#define FREUD_ALIGNED_BUFFER
+
+#include "freud/Defines.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if defined _WIN32
+#include <malloc.h>
+#endif
+
+namespace freud {
+namespace detail {
+
+/** \brief A heap allocated byte buffer with cache line alignment
+ *
+ * Views into an AlignedBuffer at offsets that are multiples of an
+ * object's alignment are suitably aligned for that object (for any
+ * alignment up to 64 bytes). Unlike std::vector, resizing does not
+ * preserve or initialize the contents, and the buffer may not be copied.
+ */
+class AlignedBuffer {
+public:
+    static const std::size_t alignment = 64;
+
+    AlignedBuffer() : m_data(NULL), m_size(0), m_capacity(0) {}
+
+    explicit AlignedBuffer(std::size_t size)
+        : m_data(NULL), m_size(0), m_capacity(0) {
+        resize(size);
+    }
+
+    ~AlignedBuffer() { release(); }
+
+    /// Change the size of the buffer. The contents are unspecified
+    /// afterwards, unless the size did not grow.
+    void resize(std::size_t size) {
+        if (size > m_capacity) {
+            release();
+            m_data = allocate(size);
+            m_capacity = size;
+        }
+        m_size = size;
+    }
+
+    /// Free the memory held by the buffer
+    void clear() {
+        release();
+        m_size = 0;
+    }
+
+    byte_t* data() { return m_data; }
+    const byte_t* data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    void swap(AlignedBuffer& other) {
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_capacity, other.m_capacity);
+    }
+
+private:
+    AlignedBuffer(const AlignedBuffer&);
+    AlignedBuffer& operator=(const AlignedBuffer&);
+
+    static byte_t* allocate(std::size_t size) {
+        void* memory = NULL;
+#if defined _WIN32
+        memory = _aligned_malloc(size ? size : 1, alignment);
+#else
+        if (posix_memalign(&memory, alignment, size ? size : 1) != 0) {
+            memory = NULL;
+        }
+#endif
+        if (!memory) {
+            throw std::bad_alloc();
+        }
+        return static_cast<byte_t*>(memory);
+    }
+
+    void release() {
+#if defined _WIN32
+        _aligned_free(m_data);
+#else
+        std::free(m_data);
+#endif
+        m_data = NULL;
+        m_capacity = 0;
+    }
+
+    byte_t* m_data;
+    std::size_t m_size;
+    std::size_t m_capacity;
+};
+
+/** \brief Inline storage for a single object of type T
+ *
+ * This allows a copy of an object to be held (for example, by an iterator)
+ * without requiring T to be default constructible or allocating memory.
+ */
+template <typename T>
+struct ObjectStorage {
+    union {
+        byte_t bytes[sizeof(T)];
+        long double align_long_double;
+        double align_double;
+        void* align_pointer;
+    };
+
+    const T& get() const { return *reinterpret_cast<const T*>(bytes); }
+};
+}
+}
+
+#endif
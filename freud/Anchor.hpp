@@ -0,0 +1,59 @@
+#ifndef FREUD_ANCHOR
+#define FREUD_ANCHOR
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace freud {
+
+/** \brief A fixed value that every instance of a MemoryObject contains
+ *
+ * An Anchor states that the 'size' bytes at 'offset' within an object,
+ * after being masked with 'mask', are equal to 'value' (also masked).
+ * Values are stored with the byte order of the host, exactly as they
+ * would be by `memcpy`ing the field into the low bytes of a uint64_t.
+ *
+ * Anchors allow a scan to skip over offsets that cannot possibly match
+ * without calling MemObject::verify. See MemoryObject::anchors.
+ */
+struct Anchor {
+    /// The byte offset of the anchored field within the object
+    std::size_t offset;
+
+    /// The number of bytes in the anchored field (between 1 and 8)
+    std::size_t size;
+
+    /// The expected value of the field
+    uint64_t value;
+
+    /// Only bits that are set in the mask are compared
+    uint64_t mask;
+};
+
+/// Create an Anchor requiring that the field at 'offset' equal 'value'
+/**
+ * The size of the field is taken from the type of 'value', so a call like
+ * `make_anchor(offsetof(Position, x), 10)` anchors an `int` field.
+ */
+template <typename T>
+Anchor make_anchor(std::size_t offset, T value) {
+    Anchor anchor = {offset, sizeof(T), 0, 0};
+    std::memcpy(&anchor.value, &value, sizeof(T));
+    std::memset(&anchor.mask, 0xFF, sizeof(T));
+    return anchor;
+}
+
+/// Create an Anchor requiring that the bits of the field at 'offset'
+/// selected by 'mask' equal those of 'value'
+template <typename T>
+Anchor make_anchor(std::size_t offset, T value, T mask) {
+    Anchor anchor = {offset, sizeof(T), 0, 0};
+    std::memcpy(&anchor.value, &value, sizeof(T));
+    std::memcpy(&anchor.mask, &mask, sizeof(T));
+    anchor.value &= anchor.mask;
+    return anchor;
+}
+}
+
+#endif
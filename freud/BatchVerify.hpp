@@ -0,0 +1,75 @@
+#ifndef FREUD_BATCH_VERIFY
+#define FREUD_BATCH_VERIFY
+
+#include "freud/Defines.hpp"
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+namespace freud {
+
+/// The largest number of candidates passed to a single call of
+/// MemObject::verify_batch (one for each bit of the returned mask)
+const std::size_t verify_batch_size = 64;
+
+/** \brief Copy one field of each candidate into an array
+ *
+ * Copies the 'Field' at 'field_offset' within each of the 'count' objects
+ * at `data + offsets[i]` into `out[i]`. The objects need not be aligned.
+ * Comparisons over the resulting arrays (see equal_mask) are simple enough
+ * for the compiler to vectorize.
+ */
+template <typename Field>
+void gather_field(const byte_t* data, const std::size_t* offsets,
+                  std::size_t count, std::size_t field_offset, Field* out) {
+    for (std::size_t i = 0; i < count; ++i) {
+        std::memcpy(&out[i], data + offsets[i] + field_offset, sizeof(Field));
+    }
+}
+
+/// A mask with bit 'i' set for every 'i' below 'count' for which
+/// `values[i] == expected`
+template <typename Field>
+uint64_t equal_mask(const Field* values, std::size_t count, Field expected) {
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        mask |= uint64_t(values[i] == expected) << i;
+    }
+    return mask;
+}
+
+namespace detail {
+
+/** \brief Whether a MemObject can verify candidates read from a Context in
+ * batches
+ *
+ * True if MemObject has a static member callable as
+ *
+ * \code{.c}
+ * uint64_t verify_batch(const Context& ctx, const byte_t* data,
+ *                       address_t base, const std::size_t* offsets,
+ *                       std::size_t count);
+ * \endcode
+ *
+ * (which may be a template over the Context).
+ */
+template <typename MemObject, typename Context>
+struct has_verify_batch {
+    typedef uint64_t (*Signature)(const Context&, const byte_t*, address_t,
+                                  const std::size_t*, std::size_t);
+
+    template <Signature>
+    struct Check {};
+
+    template <typename U>
+    static char test(Check<&U::verify_batch>*);
+
+    template <typename U>
+    static long test(...);
+
+    static const bool value = sizeof(test<MemObject>(0)) == sizeof(char);
+};
+}
+}
+
+#endif
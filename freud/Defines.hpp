@@ -10,5 +10,11 @@ namespace freud {
  */
 typedef unsigned long address_t;
 typedef char byte_t;
+
+/// A half-open range of addresses, [start_address, end_address)
+struct AddressRange {
+    address_t start_address;
+    address_t end_address;
+};
 }
 #endif
@@ -0,0 +1,99 @@
+#ifndef FREUD_FAULT_GUARD
+#define FREUD_FAULT_GUARD
+
+#include "freud/Defines.hpp"
+#include <cstddef>
+#include <cstring>
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+
+namespace freud {
+namespace detail {
+
+/// The state of a copy made by safe_copy on the current thread
+struct FaultProbe {
+    sigjmp_buf env;
+};
+
+/// The copy in progress on the current thread (or NULL)
+inline FaultProbe*& current_fault_probe() {
+    static __thread FaultProbe* probe = NULL;
+    return probe;
+}
+
+/// The SIGSEGV and SIGBUS actions that were installed before ours
+inline struct sigaction* previous_fault_actions() {
+    static struct sigaction actions[2];
+    return actions;
+}
+
+/** \brief Handles SIGSEGV and SIGBUS for safe_copy
+ *
+ * A fault during a safe_copy returns to it. Any other fault is passed to
+ * the handler that was installed before, or, if there was none, the
+ * default action is restored so the faulting instruction is retried and
+ * terminates the process as usual.
+ */
+inline void fault_handler(int number, siginfo_t* info, void* context) {
+    if (FaultProbe* probe = current_fault_probe()) {
+        siglongjmp(probe->env, 1);
+    }
+
+    struct sigaction& previous = previous_fault_actions()[number == SIGBUS];
+    if (previous.sa_flags & SA_SIGINFO) {
+        previous.sa_sigaction(number, info, context);
+    } else if (previous.sa_handler != SIG_DFL &&
+               previous.sa_handler != SIG_IGN) {
+        previous.sa_handler(number);
+    } else {
+        signal(number, SIG_DFL);
+    }
+}
+
+inline void install_fault_handler_once() {
+    // SA_NODEFER leaves the signal unblocked while the handler runs, so
+    // jumping out of it does not need to restore the signal mask (which
+    // would cost a system call on every copy)
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = &fault_handler;
+    action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &previous_fault_actions()[0]);
+    sigaction(SIGBUS, &action, &previous_fault_actions()[1]);
+}
+
+inline void install_fault_handler() {
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+    pthread_once(&once, &install_fault_handler_once);
+}
+
+/** \brief Copy memory of this process that may not be readable
+ *
+ * Copies 'size' bytes from 'source' to 'dest', returning false instead of
+ * crashing if 'source' is (or becomes, part way through the copy) unmapped
+ * or unreadable. In that case, the contents of 'dest' are unspecified.
+ * Apart from installing a signal handler the first time it is used, this
+ * makes no system calls.
+ */
+inline bool safe_copy(byte_t* dest, const byte_t* source, std::size_t size) {
+    install_fault_handler();
+
+    FaultProbe probe;
+    FaultProbe* const outer = current_fault_probe();
+    if (sigsetjmp(probe.env, 0) != 0) {
+        current_fault_probe() = outer;
+        return false;
+    }
+    current_fault_probe() = &probe;
+    __asm__ __volatile__("" ::: "memory");
+    std::memcpy(dest, source, size);
+    __asm__ __volatile__("" ::: "memory");
+    current_fault_probe() = outer;
+    return true;
+}
+}
+}
+
+#endif
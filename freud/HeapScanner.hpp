@@ -0,0 +1,489 @@
+#ifndef FREUD_HEAP_SCANNER
+#define FREUD_HEAP_SCANNER
+
+#include "freud/MemoryContext.hpp"
+#include "freud/RangeScan.hpp"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace freud {
+
+/// The default number of bytes of a heap that are read at once by a
+/// HeapScanner
+const std::size_t default_heap_window_size = 1024 * 1024;
+
+namespace detail {
+
+/// glibc's chunk size flags: the previous chunk is in use, the chunk was
+/// allocated with mmap, and the chunk belongs to an arena other than the
+/// main arena
+const address_t chunk_prev_inuse = 1;
+const address_t chunk_is_mmapped = 2;
+const address_t chunk_non_main_arena = 4;
+const address_t chunk_flags = 7;
+
+/// The size of a chunk header (the 'prev_size' and 'size' words). User
+/// data starts this far into a chunk.
+const std::size_t chunk_header_size = 2 * sizeof(address_t);
+
+/// The smallest chunk glibc creates (other than fenceposts)
+const std::size_t min_chunk_size = 4 * sizeof(address_t);
+
+/// The size and alignment of the heaps that hold the chunks of arenas
+/// other than the main arena (HEAP_MAX_SIZE)
+const address_t arena_heap_size =
+    sizeof(address_t) == 8 ? 64 * 1024 * 1024 : 1024 * 1024;
+
+/** \brief Walks the chunks of glibc malloc heaps
+ *
+ * Each in-use chunk large enough to hold a MemObject is checked at its
+ * user pointer, in batches (see ScanKernel::scan_offsets), and matches
+ * are passed to 'sink'. If the chunk headers of a heap stop making sense,
+ * the rest of the region is scanned at every aligned offset instead.
+ */
+template <typename MemObject, typename Context, typename Sink>
+class HeapWalk {
+public:
+    typedef typename MemObject::type type;
+
+    HeapWalk(Context& ctx, ScanScratch& scratch, Sink& sink,
+             std::size_t window_size)
+        : m_ctx(ctx), m_scratch(scratch), m_sink(sink),
+          m_window_size(window_size), m_region_start(0), m_region_end(0),
+          m_window_start(0), m_window_length(0), m_window_data(NULL),
+          m_candidates(0), m_fallback_regions(0) {}
+
+    /// Walk the main arena, which starts at the beginning of [heap]
+    void walk_main(address_t start, address_t end) {
+        begin_region(start, end);
+        address_t prev_size;
+        address_t size;
+        if (header(start, prev_size, size) && prev_size == 0 &&
+            (size & chunk_prev_inuse)) {
+            walk(start, end);
+        } else {
+            fall_back(start, end);
+        }
+    }
+
+    /// Walk adjacent anonymous mappings, which may hold heaps of other
+    /// arenas or chunks allocated with mmap (or neither)
+    /**
+     * The mappings start at 'starts[0]' to 'starts[count - 1]' and end at
+     * 'end'. After a heap or a run of mmapped chunks, the walk continues
+     * with whatever follows it. Memory in which neither is recognized is
+     * scanned at every offset, up to the next page where a mapping, a heap
+     * or an mmapped chunk may start.
+     */
+    void walk_anonymous(const address_t* starts, std::size_t count,
+                        address_t end) {
+        begin_region(starts[0], end);
+        const address_t page = page_size();
+        std::size_t next_start = 1;
+        for (address_t address = starts[0]; address < end;) {
+            address_t walked;
+            if (address % arena_heap_size == 0 &&
+                walk_arena_heap(address, end)) {
+                // A heap owns the whole of its HEAP_MAX_SIZE reservation,
+                // so nothing else can be mapped before its end
+                walked = address + arena_heap_size;
+                if (walked > end || walked < address) {
+                    walked = end;
+                }
+            } else {
+                walked = walk_mmapped(address, end);
+            }
+            if (walked != address) {
+                address = walked;
+                continue;
+            }
+
+            // Nothing recognizable starts here. The kernel merges adjacent
+            // anonymous mappings, so mmapped chunks can also start part way
+            // through a mapping.
+            address_t next = address + page;
+            for (; next < end; next += page) {
+                while (next_start < count && starts[next_start] < next) {
+                    ++next_start;
+                }
+                if ((next_start < count && starts[next_start] == next) ||
+                    next % arena_heap_size == 0 || mmapped_chunk(next, end)) {
+                    break;
+                }
+            }
+            if (next > end || next < address) {
+                next = end;
+            }
+            fall_back(address, next);
+            address = next;
+        }
+    }
+
+    /// The number of chunks checked with the MemObject
+    std::size_t candidates() const { return m_candidates; }
+
+    /// The number of ranges that were scanned at every offset because
+    /// their chunk headers were invalid, or no chunks were recognized in
+    /// them
+    std::size_t fallback_regions() const { return m_fallback_regions; }
+
+private:
+    void begin_region(address_t start, address_t end) {
+        m_region_start = start;
+        m_region_end = end;
+        m_window_length = 0;
+    }
+
+    /// Get a pointer to the bytes [address, address + size) of the current
+    /// region, reading a new window if needed (or NULL if they could not
+    /// be read)
+    const byte_t* fetch(address_t address, std::size_t size) {
+        if (address >= m_window_start &&
+            address - m_window_start <= m_window_length &&
+            size <= m_window_length - (address - m_window_start)) {
+            return m_window_data + (address - m_window_start);
+        }
+        flush();
+        if (address < m_region_start || address > m_region_end ||
+            size > m_region_end - address) {
+            return NULL;
+        }
+        std::size_t length = std::max(size, m_window_size);
+        if (length > m_region_end - address) {
+            length = m_region_end - address;
+        }
+        m_window_data = read_range(m_ctx, address, length, m_scratch);
+        if (!m_scratch.failed.empty()) {
+            length = std::min<std::size_t>(
+                length, m_scratch.failed[0].start_address - address);
+        }
+        m_window_start = address;
+        m_window_length = length;
+        return size <= length ? m_window_data : NULL;
+    }
+
+    /// Read the header of the chunk at 'chunk'
+    bool header(address_t chunk, address_t& prev_size, address_t& size) {
+        const byte_t* bytes = fetch(chunk, chunk_header_size);
+        if (!bytes) {
+            return false;
+        }
+        std::memcpy(&prev_size, bytes, sizeof(address_t));
+        std::memcpy(&size, bytes + sizeof(address_t), sizeof(address_t));
+        return true;
+    }
+
+    /// Queue the object at the user pointer of 'chunk' to be checked
+    void add_candidate(address_t chunk) {
+        const address_t object = chunk + chunk_header_size;
+        if (fetch(object, sizeof(type))) {
+            m_offsets.push_back(object - m_window_start);
+            ++m_candidates;
+        }
+    }
+
+    /// Check the queued candidates, which all lie in the current window
+    void flush() {
+        if (!m_offsets.empty()) {
+            ScanKernel<MemObject>::scan_offsets(m_ctx, m_window_data,
+                                                m_window_start, &m_offsets[0],
+                                                m_offsets.size(), m_sink);
+            m_offsets.clear();
+        }
+    }
+
+    /// Scan the current region from 'address' to 'end' at every offset
+    void fall_back(address_t address, address_t end) {
+        flush();
+        m_window_length = 0;
+        ++m_fallback_regions;
+
+        const std::size_t alignment = ScanKernel<MemObject>::alignment;
+        address_t start =
+            address - (address - m_region_start) % alignment;
+        scan_range<MemObject>(m_ctx, start, end, m_region_end,
+                              default_parallel_chunk_size, m_scratch, m_sink);
+    }
+
+    /** \brief Walk the chunks from 'chunk' to the top chunk, which ends at
+     * 'end'
+     *
+     * A chunk is in use if the next chunk's header has the PREV_INUSE
+     * flag. Chunks in a tcache or fastbin are also marked in use, so they
+     * are checked too.
+     */
+    void walk(address_t chunk, address_t end) {
+        for (;;) {
+            address_t prev_size;
+            address_t size;
+            if (!header(chunk, prev_size, size)) {
+                break;
+            }
+            size &= ~chunk_flags;
+            if (size > end - chunk || size % sizeof(address_t) != 0 ||
+                (size < min_chunk_size && size != chunk_header_size)) {
+                break;
+            }
+            const address_t next = chunk + size;
+            if (next == end) {
+                // The top chunk, which is never in use
+                flush();
+                return;
+            }
+
+            address_t next_prev_size;
+            address_t next_size;
+            if (end - next < chunk_header_size ||
+                !header(next, next_prev_size, next_size)) {
+                break;
+            }
+            if (size == chunk_header_size) {
+                // Only the fenceposts left at the end of a heap, when the
+                // arena moved on to a new one, are this small
+                if ((next_size & ~chunk_flags) != 0) {
+                    break;
+                }
+                flush();
+                return;
+            }
+            if ((next_size & chunk_prev_inuse) &&
+                size - sizeof(address_t) >= sizeof(type)) {
+                add_candidate(chunk);
+            }
+            chunk = next;
+        }
+        fall_back(chunk, end);
+    }
+
+    /// Walk the heap at 'start' if it starts with the heap_info of an
+    /// arena's heap
+    /**
+     * \returns false if it does not look like one
+     */
+    bool walk_arena_heap(address_t start, address_t end) {
+        // heap_info starts with the arena, the previous heap of the arena,
+        // and the number of bytes of the heap in use
+        const byte_t* bytes = fetch(start, 3 * sizeof(address_t));
+        if (!bytes) {
+            return false;
+        }
+        address_t info[3];
+        std::memcpy(info, bytes, sizeof(info));
+        const address_t arena = info[0];
+        const address_t previous = info[1];
+        const address_t size = info[2];
+        if (arena == 0 || arena % sizeof(address_t) != 0 || size == 0 ||
+            size > end - start || size % page_size() != 0 ||
+            previous % arena_heap_size != 0) {
+            return false;
+        }
+
+        // The first heap of an arena holds the arena itself (a
+        // malloc_state, whose size depends on the version of glibc) after
+        // the heap_info, and the chunks follow it. Otherwise, the chunks
+        // follow the heap_info directly.
+        address_t first = start + 4 * sizeof(address_t);
+        address_t last = start + 8 * sizeof(address_t);
+        if (arena > start && arena < last) {
+            first = arena + 256 * sizeof(address_t);
+            last = arena + 4096;
+        }
+        for (first += (-first) % chunk_header_size; first < last && first < end;
+             first += chunk_header_size) {
+            address_t prev_size;
+            address_t chunk_size;
+            if (!header(first, prev_size, chunk_size)) {
+                break;
+            }
+            if (prev_size == 0 &&
+                (chunk_size & (chunk_prev_inuse | chunk_is_mmapped)) ==
+                    chunk_prev_inuse &&
+                (chunk_size & ~chunk_flags) >= min_chunk_size &&
+                (chunk_size & ~chunk_flags) <= size - (first - start)) {
+                walk(first, start + size);
+                return true;
+            }
+        }
+        fall_back(start, start + size);
+        return true;
+    }
+
+    /// Walk the chunks allocated with mmap from 'start' (each of which is
+    /// a separate mapping, but adjacent mappings may appear as one region)
+    /**
+     * \returns The end of the last chunk walked, which is 'start' if there
+     *          were none
+     */
+    address_t walk_mmapped(address_t start, address_t end) {
+        address_t chunk = start;
+        while (const address_t size = mmapped_chunk(chunk, end)) {
+            if (size - chunk_header_size >= sizeof(type)) {
+                add_candidate(chunk);
+            }
+            chunk += size;
+        }
+        flush();
+        return chunk;
+    }
+
+    /// The size of the chunk allocated with mmap at 'chunk', or 0 if its
+    /// header is not that of one (ending by 'end')
+    address_t mmapped_chunk(address_t chunk, address_t end) {
+        address_t prev_size;
+        address_t size;
+        if (end - chunk < chunk_header_size ||
+            !header(chunk, prev_size, size) || prev_size != 0 ||
+            (size & (chunk_is_mmapped | chunk_non_main_arena)) !=
+                chunk_is_mmapped) {
+            return 0;
+        }
+        size &= ~chunk_flags;
+        if (size % page_size() != 0 || size > end - chunk) {
+            return 0;
+        }
+        return size;
+    }
+
+    Context& m_ctx;
+    ScanScratch& m_scratch;
+    Sink& m_sink;
+    std::size_t m_window_size;
+
+    address_t m_region_start;
+    address_t m_region_end;
+
+    // The bytes of the region that were read last
+    address_t m_window_start;
+    std::size_t m_window_length;
+    const byte_t* m_window_data;
+
+    // Offsets into the window of the objects waiting to be checked
+    std::vector<std::size_t> m_offsets;
+
+    std::size_t m_candidates;
+    std::size_t m_fallback_regions;
+};
+}
+
+/** \brief Scans only the objects allocated with glibc's malloc
+ *
+ * A MemoryContextIterator checks every aligned offset of every region, but
+ * an object allocated with malloc can only start at the user pointer of a
+ * malloc chunk. A HeapScanner walks the chunk headers of the main arena
+ * (the [heap] region), of the heaps of other arenas (the anonymous regions
+ * aligned to HEAP_MAX_SIZE that start with a heap_info), and of large
+ * chunks allocated with mmap, and only checks the chunks that are in use
+ * and large enough to hold the MemObject. This usually checks one or two
+ * orders of magnitude fewer candidates:
+ *
+ * \code{.c}
+ * HeapScanner<PositionMatcher> scanner(ctx);
+ * scanner.scan(PrintPosition());
+ * \endcode
+ *
+ * Named regions other than [heap], such as the main stack and the data of
+ * libraries, are not scanned. If the chunk headers of a heap are corrupt
+ * (or the target changes them while they are being walked), the rest of
+ * the heap is scanned at every aligned offset instead, as is anonymous
+ * memory in which neither a heap nor an mmapped chunk is recognized.
+ *
+ * The layout of the chunks is that of glibc for the same architecture as
+ * this process. Chunks that are free but kept in a tcache or fastbin
+ * appear to be in use, so they are checked as well.
+ */
+template <typename MemObject, typename Context = MemoryContext>
+class HeapScanner {
+public:
+    typedef typename MemObject::type type;
+
+    explicit HeapScanner(Context& ctx,
+                         std::size_t window_size = default_heap_window_size)
+        : m_ctx(ctx), m_window_size(window_size), m_candidates(0),
+          m_fallback_regions(0) {}
+
+    /// Check the allocated objects of every heap
+    /**
+     * The context's mapped regions are updated first. `callback(address,
+     * object)` is invoked for every match, in address order.
+     *
+     * \returns The number of matches
+     */
+    template <typename Callback>
+    std::size_t scan(Callback callback) {
+        typedef typename Context::MemoryRegion MemoryRegion;
+
+        m_ctx.update_regions();
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+
+        CountingSink<Callback> sink = {&callback, 0};
+        detail::HeapWalk<MemObject, Context, CountingSink<Callback> > walk(
+            m_ctx, m_scratch, sink, m_window_size);
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            if (regions[i].name == "[heap]") {
+                // The main arena can also be split between several
+                // adjacent [heap] mappings (in a forked process, for
+                // example)
+                const address_t start = regions[i].start_address;
+                while (i + 1 < regions.size() &&
+                       regions[i + 1].name == "[heap]" &&
+                       regions[i + 1].start_address ==
+                           regions[i].end_address) {
+                    ++i;
+                }
+                walk.walk_main(start, regions[i].end_address);
+            } else if (regions[i].name.empty()) {
+                // The part of a heap in use can be split between several
+                // adjacent mappings, so walk them together
+                m_starts.assign(1, regions[i].start_address);
+                while (i + 1 < regions.size() &&
+                       regions[i + 1].name.empty() &&
+                       regions[i + 1].start_address ==
+                           regions[i].end_address) {
+                    m_starts.push_back(regions[++i].start_address);
+                }
+                walk.walk_anonymous(&m_starts[0], m_starts.size(),
+                                    regions[i].end_address);
+            }
+        }
+        m_candidates = walk.candidates();
+        m_fallback_regions = walk.fallback_regions();
+        return sink.matches;
+    }
+
+    /// The number of chunks that were checked by the last scan
+    std::size_t candidates() const { return m_candidates; }
+
+    /// The number of heaps whose chunk headers were invalid in the last
+    /// scan, and which were scanned at every offset instead
+    std::size_t fallback_regions() const { return m_fallback_regions; }
+
+private:
+    HeapScanner(const HeapScanner&);
+    HeapScanner& operator=(const HeapScanner&);
+
+    template <typename Callback>
+    struct CountingSink {
+        Callback* callback;
+        std::size_t matches;
+
+        bool operator()(address_t address, const type& object) {
+            (*callback)(address, object);
+            ++matches;
+            return true;
+        }
+    };
+
+    Context& m_ctx;
+    std::size_t m_window_size;
+    detail::ScanScratch m_scratch;
+
+    // The start of each of the adjacent anonymous mappings being walked
+    std::vector<address_t> m_starts;
+
+    std::size_t m_candidates;
+    std::size_t m_fallback_regions;
+};
+}
+
+#endif
@@ -2,11 +2,14 @@
 #define FREUD_HELPER_FUNCTIONS
 
 #include "freud/MemoryContext.hpp"
+#include <algorithm>
 #include <cstdio>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace freud {
 
@@ -51,12 +54,88 @@ std::string format_as_hex(const T (&arr)[Size]) {
  * coincidence. This function provides a convenient way to perform
  * this test.
  */
-template <typename T>
-bool is_valid_address(const MemoryContext& ctx, const T* address) {
-    const std::vector<MemoryRegion>& regions = ctx.mapped_regions();
-    typename std::vector<MemoryRegion>::const_iterator iter =
-        ctx.region_containing(reinterpret_cast<address_t>(address));
-    return iter != regions.end();
+template <typename Context, typename T>
+bool is_valid_address(const Context& ctx, const T* address) {
+    return ctx.contains_address(reinterpret_cast<address_t>(address));
+}
+
+/** \brief Determine if an address is in the heap or an anonymous mapping
+ *
+ * This is a stricter form of `is_valid_address` for pointers that should
+ * refer to dynamically allocated objects.
+ */
+template <typename Context, typename T>
+bool is_heap_or_anonymous_address(const Context& ctx, const T* address) {
+    return ctx.in_heap_or_anonymous(reinterpret_cast<address_t>(address));
+}
+
+/** \brief Determine which of several addresses are valid within a context
+ *
+ * Sets 'valid[i]' to whether 'addresses[i]' is in a mapped region, for
+ * each of the 'count' addresses, and returns the number of valid
+ * addresses. An address in the same region as the one before it (the
+ * heap, for example) does not require another search. Large batches are
+ * sorted first, so that holds for all the addresses in each region.
+ */
+template <typename Context>
+std::size_t validate_addresses(const Context& ctx, const address_t* addresses,
+                               std::size_t count, bool* valid) {
+    typedef typename Context::MemoryRegion MemoryRegion;
+    typedef typename std::vector<MemoryRegion>::const_iterator RegionIter;
+
+    // A verifier checks a handful of pointers per candidate, for which
+    // sorting costs more than the searches it saves
+    const std::size_t small_batch = 16;
+    const RegionIter end = ctx.mapped_regions().end();
+    if (count <= small_batch) {
+        RegionIter region = end;
+        std::size_t result = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            const address_t address = addresses[i];
+            if (region == end || address < region->start_address ||
+                address >= region->end_address) {
+                region = ctx.region_containing(address);
+            }
+            valid[i] = region != end;
+            result += valid[i];
+        }
+        return result;
+    }
+
+    std::vector<std::pair<address_t, std::size_t> > sorted(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        sorted[i] = std::make_pair(addresses[i], i);
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    RegionIter region = end;
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        const address_t address = sorted[i].first;
+        if (region == end || address >= region->end_address) {
+            region = ctx.region_containing(address);
+        }
+        bool found = region != end && address >= region->start_address;
+        valid[sorted[i].second] = found;
+        result += found;
+    }
+    return result;
+}
+
+/** \brief Determine if every one of several addresses is valid
+ *
+ * This is equivalent to calling `is_valid_address` for each address, but
+ * stops at the first invalid address.
+ */
+template <typename Context>
+bool all_valid_addresses(const Context& ctx, const address_t* addresses,
+                         std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!ctx.contains_address(addresses[i])) {
+            return false;
+        }
+    }
+    return true;
 }
 }
 
@@ -0,0 +1,238 @@
+#ifndef FREUD_INCREMENTAL_SCANNER
+#define FREUD_INCREMENTAL_SCANNER
+
+#include "freud/MemoryContext.hpp"
+#include "freud/RangeScan.hpp"
+#include "freud/SoftDirty.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace freud {
+
+/** \brief A continuous scanner that only rescans pages that were written
+ *
+ * Each call to `scan` performs one pass over the context, like a single
+ * trip around a `scan_forever` iterator, and reports every object that
+ * currently matches. After the first pass, only the pages written since
+ * the previous pass (according to the Tracker, by default the kernel's
+ * soft-dirty bits) are read and verified again. Matches in unchanged pages
+ * are reported from the previous pass's results, so the cost of a pass is
+ * proportional to the amount of memory the target wrote.
+ *
+ * Regions that are new since the last pass are scanned in full. If the
+ * tracker is unavailable (for example, if the kernel was built without
+ * CONFIG_MEM_SOFT_DIRTY), every pass is a full rescan.
+ *
+ * There are two caveats. First, a MemObject whose `verify` depends on
+ * memory outside the object (by following pointers, for example) may
+ * give a different answer even though the object's own pages did not
+ * change. Second, a page written between reading the soft-dirty bits
+ * and clearing them is not noticed until its next write. Periodic full
+ * rescans (see set_full_rescan_interval) bound how stale results can
+ * become for either reason.
+ */
+template <typename MemObject, typename Tracker = SoftDirtyTracker>
+class IncrementalScanner {
+public:
+    typedef typename MemObject::type type;
+
+    explicit IncrementalScanner(LinuxMemoryContext& ctx)
+        : m_ctx(ctx), m_tracker(ctx.pid()), m_passes(0),
+          m_full_rescan_interval(0), m_force_full(true), m_incremental(false),
+          m_bytes_scanned(0) {}
+
+    /// Perform one pass over the context
+    /**
+     * `callback(address, object)` is invoked for every match, in address
+     * order.
+     *
+     * \returns The number of matches
+     */
+    template <typename Callback>
+    std::size_t scan(Callback callback) {
+        typedef typename LinuxMemoryContext::MemoryRegion MemoryRegion;
+
+        m_ctx.update_regions();
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+
+        bool full = m_force_full || !m_tracker.available() ||
+                    (m_full_rescan_interval != 0 &&
+                     m_passes % m_full_rescan_interval == 0);
+
+        // Find the pages written since the last pass, before the bits are
+        // cleared for the next one
+        std::vector<const RegionState*> previous(regions.size(), NULL);
+        std::vector<std::vector<AddressRange> > dirty(regions.size());
+        if (!full) {
+            for (std::size_t i = 0; i < regions.size(); ++i) {
+                previous[i] = find_previous(regions[i]);
+                if (previous[i] &&
+                    !m_tracker.dirty_ranges(regions[i].start_address,
+                                            regions[i].end_address,
+                                            dirty[i])) {
+                    previous[i] = NULL;
+                }
+            }
+        }
+        m_force_full = !m_tracker.available() || !m_tracker.clear();
+        m_incremental = !full;
+        m_bytes_scanned = 0;
+
+        std::vector<RegionState> states(regions.size());
+        std::size_t matches = 0;
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            RegionState& state = states[i];
+            state.start_address = regions[i].start_address;
+            state.end_address = regions[i].end_address;
+
+            if (previous[i]) {
+                rescan(*previous[i], dirty[i], state);
+            } else {
+                CollectSink sink = {&state};
+                m_bytes_scanned += state.end_address - state.start_address;
+                detail::scan_range<MemObject>(
+                    m_ctx, state.start_address, state.end_address,
+                    state.end_address, default_parallel_chunk_size,
+                    m_scratch, sink);
+            }
+
+            for (std::size_t m = 0; m < state.addresses.size(); ++m) {
+                callback(state.addresses[m], state.object(m));
+            }
+            matches += state.addresses.size();
+        }
+
+        m_states.swap(states);
+        ++m_passes;
+        return matches;
+    }
+
+    /// Rescan everything every 'passes' passes (0 disables full rescans
+    /// after the first pass)
+    void set_full_rescan_interval(unsigned passes) {
+        m_full_rescan_interval = passes;
+    }
+
+    /// True if the last pass only rescanned written pages
+    bool incremental() const { return m_incremental; }
+
+    /// The number of bytes that were read and scanned by the last pass
+    std::size_t bytes_scanned() const { return m_bytes_scanned; }
+
+    /// The number of passes performed so far
+    unsigned passes() const { return m_passes; }
+
+private:
+    IncrementalScanner(const IncrementalScanner&);
+    IncrementalScanner& operator=(const IncrementalScanner&);
+
+    /// The matches found in a region by the last pass
+    struct RegionState {
+        address_t start_address;
+        address_t end_address;
+        std::vector<address_t> addresses;
+        std::vector<byte_t> objects;
+
+        const type& object(std::size_t i) const {
+            return *reinterpret_cast<const type*>(&objects[i * sizeof(type)]);
+        }
+
+        void append(address_t address, const byte_t* object) {
+            addresses.push_back(address);
+            objects.insert(objects.end(), object, object + sizeof(type));
+        }
+    };
+
+    struct CollectSink {
+        RegionState* state;
+
+        bool operator()(address_t address, const type& object) {
+            state->append(address, reinterpret_cast<const byte_t*>(&object));
+            return true;
+        }
+    };
+
+    static bool starts_before(const RegionState& state, address_t address) {
+        return state.start_address < address;
+    }
+
+    template <typename MemoryRegion>
+    const RegionState* find_previous(const MemoryRegion& region) const {
+        typename std::vector<RegionState>::const_iterator iter =
+            std::lower_bound(m_states.begin(), m_states.end(),
+                             region.start_address, &starts_before);
+        if (iter != m_states.end() &&
+            iter->start_address == region.start_address &&
+            iter->end_address == region.end_address) {
+            return &*iter;
+        }
+        return NULL;
+    }
+
+    /// Update the matches of a region by rescanning the objects that
+    /// overlap a dirty range
+    void rescan(const RegionState& previous,
+                const std::vector<AddressRange>& dirty, RegionState& state) {
+        const std::size_t alignment = detail::ScanKernel<MemObject>::alignment;
+
+        // The starting addresses of the objects that need to be checked
+        std::vector<AddressRange> ranges;
+        for (std::size_t i = 0; i < dirty.size(); ++i) {
+            address_t start = dirty[i].start_address;
+            if (start - state.start_address < sizeof(type) - 1) {
+                start = state.start_address;
+            } else {
+                start -= sizeof(type) - 1;
+            }
+            start -= (start - state.start_address) % alignment;
+
+            if (!ranges.empty() && ranges.back().end_address >= start) {
+                ranges.back().end_address = dirty[i].end_address;
+            } else {
+                AddressRange range = {start, dirty[i].end_address};
+                ranges.push_back(range);
+            }
+        }
+
+        // Keep the previous matches outside of the ranges, and merge in
+        // the new matches from inside them
+        std::size_t kept = 0;
+        for (std::size_t r = 0; r < ranges.size(); ++r) {
+            while (kept < previous.addresses.size() &&
+                   previous.addresses[kept] < ranges[r].start_address) {
+                state.append(previous.addresses[kept],
+                             &previous.objects[kept * sizeof(type)]);
+                ++kept;
+            }
+            while (kept < previous.addresses.size() &&
+                   previous.addresses[kept] < ranges[r].end_address) {
+                ++kept;
+            }
+
+            CollectSink sink = {&state};
+            m_bytes_scanned += ranges[r].end_address - ranges[r].start_address;
+            detail::scan_range<MemObject>(
+                m_ctx, ranges[r].start_address, ranges[r].end_address,
+                state.end_address, default_parallel_chunk_size, m_scratch,
+                sink);
+        }
+        for (; kept < previous.addresses.size(); ++kept) {
+            state.append(previous.addresses[kept],
+                         &previous.objects[kept * sizeof(type)]);
+        }
+    }
+
+    LinuxMemoryContext& m_ctx;
+    Tracker m_tracker;
+    detail::ScanScratch m_scratch;
+    std::vector<RegionState> m_states;
+
+    unsigned m_passes;
+    unsigned m_full_rescan_interval;
+    bool m_force_full;
+    bool m_incremental;
+    std::size_t m_bytes_scanned;
+};
+}
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef FREUD_LINUX_MAPS
+#define FREUD_LINUX_MAPS
+
+#include "freud/Defines.hpp"
+#include "freud/RegionFilter.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace freud {
+namespace detail {
+
+/// Read an entire file (including /proc files, whose size is not known
+/// in advance) into 'contents'
+inline bool read_whole_file(const char* path, std::string& contents) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    contents.clear();
+    char buffer[16384];
+    for (;;) {
+        ssize_t result = read(fd, buffer, sizeof(buffer));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            close(fd);
+            return result == 0;
+        }
+        contents.append(buffer, result);
+    }
+}
+
+inline const char* parse_hex(const char* p, const char* end,
+                             unsigned long& value) {
+    value = 0;
+    for (; p < end; ++p) {
+        unsigned digit;
+        if (*p >= '0' && *p <= '9') {
+            digit = *p - '0';
+        } else if (*p >= 'a' && *p <= 'f') {
+            digit = *p - 'a' + 10;
+        } else if (*p >= 'A' && *p <= 'F') {
+            digit = *p - 'A' + 10;
+        } else {
+            break;
+        }
+        value = (value << 4) | digit;
+    }
+    return p;
+}
+
+inline const char* parse_decimal(const char* p, const char* end,
+                                 unsigned long& value) {
+    value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        value = value * 10 + (*p - '0');
+    }
+    return p;
+}
+
+inline const char* skip_spaces(const char* p, const char* end) {
+    while (p < end && *p == ' ') {
+        ++p;
+    }
+    return p;
+}
+
+/** \brief Parse the contents of a /proc/<pid>/maps file
+ *
+ * Each line has the form
+ *
+ *     start-end perms offset major:minor inode    pathname
+ *
+ * Regions accepted by 'filter' are appended to 'regions', which must hold
+ * a type with the members of BaseMemoryContext::MemoryRegion. The
+ * contents are parsed in place, so the only allocations are for the names
+ * of accepted regions.
+ */
+template <typename MemoryRegion>
+void parse_maps(const std::string& contents, const RegionFilter& filter,
+                std::vector<MemoryRegion>& regions) {
+    const char* p = contents.data();
+    const char* const end = p + contents.size();
+    MemoryRegion region;
+
+    while (p < end) {
+        const char* line_end = p;
+        while (line_end < end && *line_end != '\n') {
+            ++line_end;
+        }
+
+        unsigned long value;
+        p = parse_hex(p, line_end, value);
+        region.start_address = value;
+        if (p < line_end && *p == '-') {
+            ++p;
+        }
+        p = parse_hex(p, line_end, value);
+        region.end_address = value;
+        p = skip_spaces(p, line_end);
+
+        const char flags[] = {'r', 'w', 'x'};
+        const unsigned bits[] = {REGION_READ, REGION_WRITE, REGION_EXECUTE};
+        region.permissions = 0;
+        for (std::size_t i = 0; i < 3 && p + i < line_end; ++i) {
+            if (p[i] == flags[i]) {
+                region.permissions |= bits[i];
+            }
+        }
+        if (p + 3 < line_end && p[3] == 's') {
+            region.permissions |= REGION_SHARED;
+        }
+        while (p < line_end && *p != ' ') {
+            ++p;
+        }
+        p = skip_spaces(p, line_end);
+
+        p = parse_hex(p, line_end, value);
+        region.offset = value;
+        p = skip_spaces(p, line_end);
+
+        // Skip the device
+        while (p < line_end && *p != ' ') {
+            ++p;
+        }
+        p = skip_spaces(p, line_end);
+
+        p = parse_decimal(p, line_end, value);
+        region.inode = value;
+        p = skip_spaces(p, line_end);
+
+        // The rest of the line is the pathname, which may contain spaces
+        const char* name = p;
+        std::size_t name_length = line_end - p;
+        while (name_length > 0 && name[name_length - 1] == ' ') {
+            --name_length;
+        }
+
+        if (region.end_address > region.start_address &&
+            filter.accepts(name, name_length, region.permissions)) {
+            region.name.assign(name, name_length);
+            regions.push_back(region);
+        }
+        p = line_end + 1;
+    }
+}
+}
+}
+
+#endif
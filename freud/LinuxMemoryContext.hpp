@@ -1,8 +1,14 @@
 #ifndef FREUD_LINUX_MEMORY_CONTEXT
 #define FREUD_LINUX_MEMORY_CONTEXT
 
+#include "freud/AlignedBuffer.hpp"
+#include "freud/LinuxMaps.hpp"
+#include "freud/LinuxReadBackend.hpp"
 #include "freud/MemoryContext.hpp"
-#include <cstdlib>
+#include "freud/PageCache.hpp"
+#include "freud/ParallelScan.hpp"
+#include "freud/Prefetcher.hpp"
+#include "freud/ThreadPool.hpp"
 #include <sstream>
 
 namespace freud {
@@ -19,121 +25,605 @@ namespace freud {
  * In practice, it is necessary to read larger blocks of memory and
  * cache the results to improve performance. It is possible, therefore,
  * to get 'stale' results from a read, when reading bytes that are
- * in the same region as a previous read. In the future, an interface
+ * in the same window as a previous read. In the future, an interface
  * may be exposed allowing the user to explicitly request a read that
  * is not cached.
+ *
+ * Regions are cached one window (see set_window_size) at a time, so the
+ * memory used by the cache does not depend on the size of the regions.
+ * While one window is scanned, the following windows are read on a
+ * background thread (see set_prefetch_depth).
+ *
+ * Calls to `read` are served from a separate cache of recently used pages
+ * (see set_page_cache_size), so a verifier following pointers from the
+ * object being checked does not evict the window being scanned.
+ *
+ * Bytes are read with one of the ReadBackend mechanisms. By default,
+ * `process_vm_readv` is used, falling back to /proc/<pid>/mem if the
+ * system call is unavailable (for example, when blocked by seccomp).
  */
 class LinuxMemoryContext : public BaseMemoryContext<LinuxMemoryContext> {
 public:
-    LinuxMemoryContext(unsigned long pid, bool heap_only = false)
-        : BaseMemoryContext(), m_mem(), m_pid(pid), m_heap_only(heap_only) {
-        std::ostringstream ss;
-        ss << "/proc/" << pid << "/mem";
-        m_mem.open(ss.str().c_str());
+    LinuxMemoryContext(unsigned long pid, bool heap_only = false,
+                       ReadBackend backend = PROCESS_VM_READV_BACKEND)
+        : BaseMemoryContext(), m_pid(pid),
+          m_filter(heap_only ? RegionFilter::heap_only() : RegionFilter()),
+          m_backend(backend), m_window_region(), m_window_start(0),
+          m_window_offset(0), m_window_size(default_window_size),
+          m_prefetch_enabled(true), m_prefetcher(*this),
+          m_page_cache(default_page_cache_pages, detail::page_size()) {
+        m_vm_reader.open(pid);
+        m_mem_reader.open(pid);
+        update_regions();
+    }
+
+    /// Create a context that only reads the regions accepted by 'filter'
+    /**
+     * Regions rejected by the filter are never read, and are not part of
+     * mapped_regions. For example, RegionFilter::writable_data skips code,
+     * guard pages and read-only file mappings, which cannot hold
+     * dynamically created objects.
+     */
+    LinuxMemoryContext(unsigned long pid, const RegionFilter& filter,
+                       ReadBackend backend = PROCESS_VM_READV_BACKEND)
+        : BaseMemoryContext(), m_pid(pid), m_filter(filter),
+          m_backend(backend), m_window_region(), m_window_start(0),
+          m_window_offset(0), m_window_size(default_window_size),
+          m_prefetch_enabled(true), m_prefetcher(*this),
+          m_page_cache(default_page_cache_pages, detail::page_size()) {
+        m_vm_reader.open(pid);
+        m_mem_reader.open(pid);
         update_regions();
     }
 
     ~LinuxMemoryContext() {}
 
-    bool read(address_t address, std::vector<char>& buffer) {
-        return read(address, buffer, region_containing(address));
+    /// Read 'buffer.size()' bytes starting at 'address'
+    /**
+     * Small reads within a mapped region are served from the page cache,
+     * so they may return stale bytes if the pages were read recently. The
+     * page cache is shared by all threads, so `read` may be called from a
+     * verifier during scan_parallel.
+     */
+    bool read(address_t address, std::vector<char>& buffer) const {
+        // Another thread may update the regions, so the lookup and the
+        // test for the end must both use the same table
+        const RegionTableRef table = region_table();
+        const std::vector<MemoryRegion>::const_iterator iter =
+            table->region_containing(address);
+        if (iter == table->regions().end()) {
+            // We don't know of a region containing the address, so just
+            // try to read it directly
+            return buffer.empty() || read_without_cache(address, buffer);
+        }
+        return read(address, buffer, iter);
     }
 
-    bool
-    read(address_t address, std::vector<char>& buffer,
-         std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter) {
-        MemoryRegion& cached = m_cached_region.first;
+    /// Read 'buffer.size()' bytes starting at 'address', which is expected
+    /// to be in the region 'iter' refers to
+    /**
+     * 'iter' must refer to a region (of any version of the table), not to
+     * the end of one. If the bytes are not all in that region, they are
+     * read directly.
+     */
+    bool read(
+        address_t address, std::vector<char>& buffer,
+        std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter)
+        const {
+        if (buffer.empty()) {
+            return true;
+        }
 
-        // If we don't know of a region containing the address, just
-        // try to read it directly
-        if (iter == m_regions.end()) {
+        const address_t end = address + buffer.size();
+        if (address < iter->start_address || end > iter->end_address ||
+            end < address || buffer.size() > max_cached_read) {
             return read_without_cache(address, buffer);
         }
+        return read_cached(address, &*buffer.begin(), buffer.size());
+    }
 
-        if (m_cached_region.second.size() == 0 ||
-            address < cached.start_address || address >= cached.end_address) {
-            // cache the region containing address
+    /// Read a T from 'address'
+    /**
+     * This is convenient for following pointers, for example, from a
+     * verifier:
+     *
+     * \code{.c}
+     * Node next = ctx.read<Node>(reinterpret_cast<address_t>(node.next));
+     * \endcode
+     *
+     * If the bytes could not be read, '*ok' (if given) is set to false and
+     * an object whose bytes are all zero is returned.
+     */
+    template <typename T>
+    T read(address_t address, bool* ok = NULL) const {
+        detail::ObjectStorage<T> storage;
+        std::vector<char> buffer(sizeof(T));
+        const bool result = read(address, buffer);
+        if (!result) {
+            std::fill(buffer.begin(), buffer.end(), 0);
+        }
+        std::memcpy(storage.bytes, &buffer[0], sizeof(T));
+        if (ok) {
+            *ok = result;
+        }
+        return storage.get();
+    }
+
+    /// Get a pointer to the cached bytes at an address
+    /**
+     * The window starting at 'address' in the region described by 'iter'
+     * is read into the context's cache if it is not already present. On
+     * success, 'data' points to the cached byte for 'address' and
+     * 'available' is the number of cached bytes from that point. At least
+     * 'size' bytes are available, unless the region ends sooner. Bytes at
+     * aligned offsets from the start of the region are suitably aligned.
+     * 'iter' must refer to a region, which may come from an older
+     * region_table than the current one.
+     *
+     * Views are expected to move forward through a region, so the next
+     * window is prefetched. A view of bytes near the end of the current
+     * window is served from the prefetched window with those bytes
+     * carried over, so an object that spans the edge of a window is still
+     * seen whole.
+     *
+     * The pointer remains valid until the next call to `read`, `view` or
+     * `update_regions` on this context.
+     */
+    bool view(address_t address,
+              std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+              const byte_t*& data, std::size_t& available,
+              std::size_t size = 1) {
+        return load(address, iter, size, m_prefetch_enabled, data, available);
+    }
 
-            m_cached_region.first = *iter;
-            m_cached_region.second.resize(iter->end_address -
-                                          iter->start_address);
+    /// The number of bytes of a region that are cached at once
+    std::size_t window_size() const { return m_window_size; }
 
-            if (!read_without_cache(iter->start_address,
-                                    m_cached_region.second)) {
-                // This has the effect of skipping regions that have shrunk
-                // since the mapped regions were last updated. This might
-                // not work correctly for some applications, but we can't
-                // update_regions without invalidating other iterators.
-                return false;
+    /// Set the number of bytes of a region that are cached at once
+    /**
+     * Smaller windows use less memory, while larger windows require fewer
+     * reads. The value is rounded up to a whole number of pages.
+     */
+    void set_window_size(std::size_t size) {
+        const std::size_t page = detail::page_size();
+        m_window_size = size < page ? page : (size + page - 1) / page * page;
+        reset_window();
+    }
+
+    /// Enable or disable reading the next windows in the background
+    void set_prefetch(bool enabled) {
+        m_prefetch_enabled = enabled;
+        m_prefetcher.cancel();
+    }
+
+    /// The number of windows that may be read ahead of the scan
+    std::size_t prefetch_depth() const { return m_prefetcher.depth(); }
+
+    /// Set the number of windows that may be read ahead of the scan
+    /**
+     * While a window is scanned, a background thread reads up to 'depth'
+     * of the following windows (continuing into the following regions),
+     * and stops once that many are waiting to be scanned. A deeper queue
+     * keeps the reader busy when the time taken to read or to scan a
+     * window varies, such as across many small regions, at the cost of up
+     * to 'depth' additional windows of memory. The default is 1.
+     */
+    void set_prefetch_depth(std::size_t depth) {
+        m_prefetcher.set_depth(depth);
+    }
+
+    /// Read several (possibly discontiguous) ranges of the target at once
+    /**
+     * With the PROCESS_VM_READV_BACKEND, the requests are batched into as
+     * few system calls as possible. The bytes_read member of each request
+     * is updated, and page ranges that could not be read are appended to
+     * 'failed' (if provided). The work done is added to the context's
+     * read_counters, and to 'counters' (if provided).
+     *
+     * \returns true if every request was read completely
+     */
+    bool read_batch(std::vector<ReadRequest>& requests,
+                    std::vector<FailedRange>* failed = NULL,
+                    ScanCounters* counters = NULL) {
+        ScanCounters work;
+        if (read_backend() == PROCESS_VM_READV_BACKEND &&
+            !m_vm_reader.read_batch(requests, failed, work)) {
+            // The system call is not permitted here, so fall back to
+            // /proc/<pid>/mem for this and all later reads. Several
+            // threads may get here at once; the file was opened by the
+            // constructor, so only the backend itself changes.
+            __sync_bool_compare_and_swap(&m_backend,
+                                         int(PROCESS_VM_READV_BACKEND),
+                                         int(PROC_MEM_BACKEND));
+        }
+        if (read_backend() == PROC_MEM_BACKEND) {
+            m_mem_reader.read_batch(requests, failed, work);
+        }
+
+        bool result = true;
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            FREUD_STAT(work.bytes_requested += requests[i].size);
+            FREUD_STAT(work.bytes_read += requests[i].bytes_read);
+            if (requests[i].bytes_read != requests[i].size) {
+                result = false;
             }
         }
+        FREUD_STAT(work.failed_reads += result ? 0 : 1);
+        FREUD_STAT(m_read_counters.add(work));
+        FREUD_STAT(if (counters) { counters->add(work); });
+        return result;
+    }
 
-        if (address >= cached.start_address && address < cached.end_address) {
-            // read from cached bytes
+    /// Scan the context for MemObjects using several threads
+    /**
+     * Regions are split into chunks of 'chunk_size' bytes, which are
+     * checked by a pool of 'threads' workers. `callback(address, object)`
+     * is invoked for each match. Calls to the callback are serialized, but
+     * may come from any worker thread. If 'ordered' is true, matches are
+     * delivered in increasing address order; otherwise they are delivered
+     * as soon as their chunk has been scanned.
+     *
+     * MemObject::verify may be called concurrently, so it must only use
+     * the const interface of the context.
+     *
+     * If 'stats' is given, it receives the statistics of the scan.
+     *
+     * \returns The number of matches found
+     */
+    template <typename MemObject, typename Callback>
+    std::size_t
+    scan_parallel(unsigned threads, Callback callback, bool ordered = false,
+                  std::size_t chunk_size = default_parallel_chunk_size,
+                  ScanStats* stats = NULL) {
+        detail::ParallelScan<MemObject, LinuxMemoryContext, Callback> scan(
+            *this, callback, ordered);
+        return scan.run(threads, chunk_size, stats);
+    }
 
-            read_from_cache(address, buffer);
-            return true;
+    /// The number of pages held by the cache used by `read`
+    std::size_t page_cache_size() const { return m_page_cache.capacity(); }
+
+    /// Set the number of pages held by the cache used by `read`
+    /**
+     * The cache is emptied. A size of 0 disables the cache, so every call
+     * to `read` reads the target directly.
+     */
+    void set_page_cache_size(std::size_t pages) {
+        detail::ScopedLock lock(m_page_cache_mutex);
+        m_page_cache.set_capacity(pages);
+    }
+
+    /// The ID of the process this context reads
+    unsigned long pid() const { return m_pid; }
+
+    /// The mechanism currently used to read target memory
+    ReadBackend read_backend() const {
+        return ReadBackend(__sync_fetch_and_add(&m_backend, 0));
+    }
+
+    /// Select the mechanism used to read target memory
+    /**
+     * This must not be called while other threads are reading the
+     * context, as it may reopen /proc/<pid>/mem.
+     */
+    void set_read_backend(ReadBackend backend) {
+        if (backend == PROC_MEM_BACKEND && !m_mem_reader.is_open()) {
+            m_mem_reader.open(m_pid);
         }
-        return false;
+        __sync_lock_test_and_set(&m_backend, int(backend));
     }
 
+    /// The filter selecting which regions are read
+    const RegionFilter& region_filter() const { return m_filter; }
+
+    /// Change the region filter. The regions are updated immediately.
+    void set_region_filter(const RegionFilter& filter) {
+        m_filter = filter;
+        update_regions();
+    }
+
+    /// Read the target's mapped regions again
+    /**
+     * If they changed, a new version of the regions is published (see
+     * region_table). Iterators that are part way through a scan keep the
+     * version they started with. The cached bytes are discarded either
+     * way, so later reads see the target's current memory.
+     */
     void update_regions() {
-        m_regions.clear();
-        m_cached_region.second.resize(0);
+        reset_window();
+        {
+            detail::ScopedLock lock(m_page_cache_mutex);
+            m_page_cache.clear();
+        }
         std::ostringstream ss;
         ss << "/proc/" << m_pid << "/maps";
-        std::ifstream maps_file(ss.str().c_str());
+        std::vector<MemoryRegion> regions;
+        if (detail::read_whole_file(ss.str().c_str(), m_maps_contents)) {
+            detail::parse_maps(m_maps_contents, m_filter, regions);
+        }
+        publish_regions(regions);
+    }
+
+private:
+    detail::ProcMemReader m_mem_reader;
+    detail::ProcessVmReader m_vm_reader;
+    unsigned long m_pid;
+    RegionFilter m_filter;
+    std::string m_maps_contents;
+
+    // The current ReadBackend, which reads may change concurrently
+    mutable volatile int m_backend;
+    // The current window holds the bytes [m_window_start, window_end()) of
+    // m_window_region, starting at m_window_offset in m_window.
+    MemoryRegion m_window_region;
+    address_t m_window_start;
+    std::size_t m_window_offset;
+    detail::AlignedBuffer m_window;
+    std::size_t m_window_size;
+
+    bool m_prefetch_enabled;
+    detail::Prefetcher<LinuxMemoryContext> m_prefetcher;
 
-        std::string region_info;
-        while (std::getline(maps_file, region_info)) {
-            std::string addrs = region_info.substr(0, region_info.find(" "));
+    // The region of the newest read queued in m_prefetcher, and its end
+    std::vector<MemoryRegion>::const_iterator m_prefetch_region;
+    address_t m_prefetch_region_end;
 
-            std::string start_addr_s = addrs.substr(0, addrs.find("-"));
-            std::string end_addr_s = addrs.substr(addrs.find("-") + 1);
+    // Pages read by `read`, which may be called concurrently
+    mutable detail::PageCache m_page_cache;
+    mutable detail::Mutex m_page_cache_mutex;
 
-            address_t start_addr = std::strtoul(start_addr_s.c_str(), NULL, 16);
-            address_t end_addr = std::strtoul(end_addr_s.c_str(), NULL, 16);
+    static const std::size_t default_window_size = 16 * 1024 * 1024;
 
-            std::string name = region_info.substr(region_info.rfind(" ") + 1);
+    // Reads larger than this bypass the page cache
+    static const std::size_t max_cached_read = 64 * 1024;
 
-            MemoryRegion region = {name, start_addr, end_addr};
+    // The most bytes that are carried over from the previous window when a
+    // prefetched window is used
+    static const std::size_t window_headroom = 64 * 1024;
 
-            if (m_heap_only && name == "[heap]") {
-                m_regions.push_back(region);
-                break;
-            } else if (!m_heap_only) {
-                m_regions.push_back(region);
+    address_t window_end() const {
+        return m_window_start + (m_window.size() - m_window_offset);
+    }
+
+    static bool same_region(const MemoryRegion& a, const MemoryRegion& b) {
+        return a.start_address == b.start_address &&
+               a.end_address == b.end_address;
+    }
+
+    void reset_window() {
+        m_prefetcher.cancel();
+        m_window.clear();
+        m_window_offset = 0;
+        m_window_start = 0;
+    }
+
+    bool load(address_t address,
+              std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+              std::size_t size, bool prefetch, const byte_t*& data,
+              std::size_t& available) {
+        if (address < iter->start_address || address >= iter->end_address) {
+            return false;
+        }
+
+        address_t wanted_end = address + size;
+        if (wanted_end > iter->end_address || wanted_end < address) {
+            wanted_end = iter->end_address;
+        }
+
+        bool cached = !m_window.empty() &&
+                      same_region(m_window_region, *iter) &&
+                      address >= m_window_start && wanted_end <= window_end();
+        if (!cached && !use_prefetched(address, iter, wanted_end) &&
+            !read_window(address, iter, size)) {
+            return false;
+        }
+
+        if (prefetch) {
+            queue_prefetches(iter);
+        }
+
+        std::size_t offset = m_window_offset + (address - m_window_start);
+        data = m_window.data() + offset;
+        available = m_window.size() - offset;
+
+        // A window prefetched for a newer version of the regions may
+        // extend past the end of the region in 'iter'
+        if (available > iter->end_address - address) {
+            available = iter->end_address - address;
+        }
+        return true;
+    }
+
+    /// Queue reads of the windows after the current one until the
+    /// prefetcher is full. Once the rest of the current region has been
+    /// queued, the windows of the following regions are queued.
+    /**
+     * 'iter' may belong to an older version of the regions (held by an
+     * iterator), so the following regions are found in the current
+     * version. While the rest of 'iter' is being queued, m_prefetch_region
+     * is the end of the current regions.
+     */
+    void queue_prefetches(
+        std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter) {
+        const std::vector<MemoryRegion>& regions = mapped_regions();
+        std::vector<MemoryRegion>::const_iterator region = regions.end();
+        address_t next = window_end();
+        address_t region_end = iter->end_address;
+        if (m_prefetcher.pending()) {
+            region = m_prefetch_region;
+            next = m_prefetcher.end_address();
+            region_end = m_prefetch_region_end;
+        }
+
+        while (!m_prefetcher.full()) {
+            if (next >= region_end) {
+                if (region == regions.end()) {
+                    region = region_table()->region_after(next);
+                } else {
+                    ++region;
+                }
+                if (region == regions.end()) {
+                    return;
+                }
+                if (next < region->start_address) {
+                    next = region->start_address;
+                }
+                region_end = region->end_address;
+            }
+            address_t next_end = next + m_window_size;
+            if (next_end > region_end || next_end < next) {
+                next_end = region_end;
             }
+            m_prefetcher.start(next, next_end - next, window_headroom);
+            m_prefetch_region = region;
+            m_prefetch_region_end = region_end;
+            next = next_end;
         }
     }
 
-private:
-    std::ifstream m_mem;
-    unsigned long m_pid;
-    bool m_heap_only;
-    std::pair<MemoryRegion, std::vector<char> //
-              >
-        m_cached_region;
+    /// Make the oldest prefetched window current, if it continues the
+    /// current window (or starts the region at 'address') and covers the
+    /// requested bytes
+    bool use_prefetched(
+        address_t address,
+        std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+        address_t wanted_end) {
+        if (!m_prefetcher.pending()) {
+            return false;
+        }
 
-    void read_from_cache(address_t address, std::vector<char>& buffer) {
-        address_t region_offset = address - m_cached_region.first.start_address;
-        std::copy(m_cached_region.second.begin() + region_offset,
-                  m_cached_region.second.begin() + region_offset +
-                      buffer.size(),
-                  buffer.begin());
+        const address_t next_start = m_prefetcher.address();
+        const address_t next_end = next_start + m_prefetcher.size();
+        const bool continues =
+            !m_window.empty() && same_region(m_window_region, *iter) &&
+            next_start == window_end() && address >= m_window_start &&
+            address <= next_start && next_start - address <= window_headroom;
+        const bool starts_region =
+            next_start == iter->start_address && address == next_start;
+        if ((!continues && !starts_region) || wanted_end > next_end) {
+            m_prefetcher.cancel();
+            return false;
+        }
+
+        if (!m_prefetcher.finish()) {
+            return false;
+        }
+
+        // Carry the unscanned tail of the current window over in front of
+        // the prefetched bytes
+        const std::size_t tail = continues ? next_start - address : 0;
+        detail::AlignedBuffer& next = m_prefetcher.buffer();
+        const std::size_t offset = m_prefetcher.headroom() - tail;
+        if (tail != 0) {
+            std::memcpy(next.data() + offset,
+                        m_window.data() + m_window_offset +
+                            (address - m_window_start),
+                        tail);
+        }
+
+        m_window.swap(next);
+        m_window_region = *iter;
+        m_window_start = address;
+        m_window_offset = offset;
+        return true;
     }
 
-    bool read_without_cache(address_t address, std::vector<char>& buffer) {
-        m_mem.seekg(address);
+    bool read_window(
+        address_t address,
+        std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+        std::size_t size) {
+        m_prefetcher.cancel();
 
-        m_mem.read(&*buffer.begin(), buffer.size());
-        bool result = m_mem.good();
-        if (!result) {
-            // FIXME: this probably isn't always going to work
-            m_mem.clear();
+        address_t end = address + (size > m_window_size ? size : m_window_size);
+        if (end > iter->end_address || end < address) {
+            end = iter->end_address;
+        }
+
+        m_window_region = *iter;
+        m_window_start = address;
+        m_window_offset = 0;
+        m_window.resize(end - address);
+
+        ReadRequest request = {address, m_window.data(), m_window.size(), 0};
+        std::vector<ReadRequest> requests(1, request);
+        if (!read_batch(requests)) {
+            // This has the effect of skipping regions that have shrunk
+            // since the iterator's version of the regions was published.
+            // The regions are not updated here, as the iterator will only
+            // see the change when it starts its next pass.
+            m_window.resize(0);
+            return false;
+        }
+        return true;
+    }
+
+    bool read_without_cache(address_t address,
+                            std::vector<char>& buffer) const {
+        if (buffer.empty()) {
+            return true;
+        }
+        return read_direct(address, reinterpret_cast<byte_t*>(&buffer[0]),
+                           buffer.size());
+    }
+
+    /// Read bytes from the target with the current backend, without
+    /// changing it
+    bool read_direct(address_t address, byte_t* buffer,
+                     std::size_t size) const {
+        ReadRequest request = {address, buffer, size, 0};
+        std::vector<ReadRequest> requests(1, request);
+        ScanCounters work;
+        if (read_backend() != PROCESS_VM_READV_BACKEND ||
+            !m_vm_reader.read_batch(requests, NULL, work)) {
+            m_mem_reader.read_batch(requests, NULL, work);
         }
+        const bool result = requests[0].bytes_read == size;
+        FREUD_STAT(work.bytes_requested += size);
+        FREUD_STAT(work.bytes_read += requests[0].bytes_read);
+        FREUD_STAT(work.failed_reads += result ? 0 : 1);
+        FREUD_STAT(m_read_counters.add(work));
         return result;
     }
+
+    /// Copy 'size' bytes at 'address' out of the page cache, reading the
+    /// pages that are not cached
+    bool read_cached(address_t address, char* out, std::size_t size) const {
+        const std::size_t page_size = m_page_cache.page_size();
+        std::vector<byte_t> page;
+        while (size > 0) {
+            const address_t page_start = address - address % page_size;
+            const std::size_t offset = address - page_start;
+            const std::size_t count =
+                size < page_size - offset ? size : page_size - offset;
+            {
+                detail::ScopedLock lock(m_page_cache_mutex);
+                const byte_t* data = m_page_cache.find(page_start);
+                if (data) {
+                    std::memcpy(out, data + offset, count);
+                    address += count;
+                    out += count;
+                    size -= count;
+                    continue;
+                }
+            }
+
+            // The lock is not held while reading, so other threads may use
+            // the cache in the meantime
+            page.resize(page_size);
+            if (!read_direct(page_start, &page[0], page_size)) {
+                return false;
+            }
+            {
+                detail::ScopedLock lock(m_page_cache_mutex);
+                m_page_cache.insert(page_start, &page[0]);
+            }
+            std::memcpy(out, &page[offset], count);
+            address += count;
+            out += count;
+            size -= count;
+        }
+        return true;
+    }
 };
 
 /// \cond
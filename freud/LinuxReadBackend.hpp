@@ -0,0 +1,261 @@
+#ifndef FREUD_LINUX_READ_BACKEND
+#define FREUD_LINUX_READ_BACKEND
+
+#include "freud/Defines.hpp"
+#include "freud/ScanStats.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+
+namespace freud {
+
+/// The mechanisms a LinuxMemoryContext may use to read target memory
+enum ReadBackend {
+    /// Read with `pread` on the /proc/<pid>/mem file
+    PROC_MEM_BACKEND,
+
+    /// Read with the `process_vm_readv` system call
+    PROCESS_VM_READV_BACKEND
+};
+
+/** \brief A single contiguous read from a target's address space
+ *
+ * 'size' bytes starting at 'address' are copied into 'buffer'. After a
+ * batched read, 'bytes_read' holds the number of bytes that could actually
+ * be read. Bytes of the buffer that could not be read are zero filled.
+ */
+struct ReadRequest {
+    /// The first address in the target to read
+    address_t address;
+
+    /// The destination for the bytes (must hold at least 'size' bytes)
+    byte_t* buffer;
+
+    /// The number of bytes to read
+    std::size_t size;
+
+    /// The number of bytes that were successfully read
+    std::size_t bytes_read;
+};
+
+/// A range of target addresses that could not be read
+typedef AddressRange FailedRange;
+
+namespace detail {
+
+inline std::size_t page_size() {
+    static const std::size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+inline void add_failed_range(std::vector<FailedRange>* failed,
+                             address_t start, address_t end) {
+    if (!failed) {
+        return;
+    }
+    if (!failed->empty() && failed->back().end_address == start) {
+        failed->back().end_address = end;
+        return;
+    }
+    FailedRange range = {start, end};
+    failed->push_back(range);
+}
+
+/** \brief Finish a request that was only partially read
+ *
+ * The remainder of 'request' (after 'bytes_read') is read one page at a
+ * time using 'reader', which must provide
+ * `ssize_t read_once(address_t, byte_t*, std::size_t)`. Unreadable pages
+ * are zero filled and reported in 'failed'.
+ */
+template <typename Reader>
+void read_remainder_by_page(const Reader& reader, ReadRequest& request,
+                            std::vector<FailedRange>* failed,
+                            ScanCounters& counters) {
+    address_t address = request.address + request.bytes_read;
+    const address_t end = request.address + request.size;
+
+    while (address < end) {
+        address_t page_end = (address & ~(page_size() - 1)) + page_size();
+        if (page_end > end || page_end < address) {
+            page_end = end;
+        }
+        byte_t* dest = request.buffer + (address - request.address);
+        std::size_t length = page_end - address;
+
+        ssize_t result = reader.read_once(address, dest, length);
+        FREUD_STAT(++counters.read_calls);
+        if (result < 0 || static_cast<std::size_t>(result) < length) {
+            std::size_t good = result > 0 ? result : 0;
+            std::memset(dest + good, 0, length - good);
+            request.bytes_read += good;
+            add_failed_range(failed, address + good, page_end);
+        } else {
+            request.bytes_read += length;
+        }
+        address = page_end;
+    }
+}
+
+/// Reads target memory with `pread` on /proc/<pid>/mem
+class ProcMemReader {
+public:
+    ProcMemReader() : m_fd(-1) {}
+
+    ~ProcMemReader() { close(); }
+
+    bool open(unsigned long pid) {
+        close();
+        std::ostringstream ss;
+        ss << "/proc/" << pid << "/mem";
+        m_fd = ::open(ss.str().c_str(), O_RDONLY);
+        return m_fd >= 0;
+    }
+
+    void close() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+            m_fd = -1;
+        }
+    }
+
+    bool is_open() const { return m_fd >= 0; }
+
+    ssize_t read_once(address_t address, byte_t* buffer,
+                      std::size_t size) const {
+        std::size_t total = 0;
+        while (total < size) {
+            ssize_t result = pread(m_fd, buffer + total, size - total,
+                                   static_cast<off_t>(address + total));
+            if (result < 0 && errno == EINTR) {
+                continue;
+            } else if (result <= 0) {
+                return total > 0 ? static_cast<ssize_t>(total) : result;
+            }
+            total += result;
+        }
+        return total;
+    }
+
+    /// Perform each request with a separate `pread`
+    void read_batch(std::vector<ReadRequest>& requests,
+                    std::vector<FailedRange>* failed,
+                    ScanCounters& counters) const {
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            ReadRequest& request = requests[i];
+            ssize_t result =
+                read_once(request.address, request.buffer, request.size);
+            FREUD_STAT(++counters.read_calls);
+            request.bytes_read = result > 0 ? result : 0;
+            if (request.bytes_read < request.size) {
+                read_remainder_by_page(*this, request, failed, counters);
+            }
+        }
+    }
+
+private:
+    // Not copyable, as the descriptor is owned
+    ProcMemReader(const ProcMemReader&);
+    ProcMemReader& operator=(const ProcMemReader&);
+
+    int m_fd;
+};
+
+/** \brief Reads target memory with `process_vm_readv`
+ *
+ * Batches are split into groups of at most IOV_MAX requests, each of which
+ * is read with a single system call. Partial reads are resolved by reading
+ * the remainder of the failing request page by page, and then resuming the
+ * batch at the next request.
+ */
+class ProcessVmReader {
+public:
+    ProcessVmReader() : m_pid(0) {}
+
+    void open(unsigned long pid) { m_pid = pid; }
+
+    ssize_t read_once(address_t address, byte_t* buffer,
+                      std::size_t size) const {
+        struct iovec local = {buffer, size};
+        struct iovec remote = {reinterpret_cast<void*>(address), size};
+        return process_vm_readv(m_pid, &local, 1, &remote, 1, 0);
+    }
+
+    /// Returns false if the system call itself is unusable (for example,
+    /// because it is blocked by a seccomp policy or not supported)
+    bool read_batch(std::vector<ReadRequest>& requests,
+                    std::vector<FailedRange>* failed,
+                    ScanCounters& counters) const {
+        static const std::size_t max_iovecs = 1024;
+
+        std::vector<struct iovec> local;
+        std::vector<struct iovec> remote;
+        local.reserve(std::min(requests.size(), max_iovecs));
+        remote.reserve(std::min(requests.size(), max_iovecs));
+
+        std::size_t next = 0;
+        while (next < requests.size()) {
+            local.clear();
+            remote.clear();
+            for (std::size_t i = next;
+                 i < requests.size() && local.size() < max_iovecs; ++i) {
+                struct iovec l = {requests[i].buffer, requests[i].size};
+                struct iovec r = {
+                    reinterpret_cast<void*>(requests[i].address),
+                    requests[i].size};
+                local.push_back(l);
+                remote.push_back(r);
+            }
+
+            ssize_t result = process_vm_readv(m_pid, &local[0], local.size(),
+                                              &remote[0], remote.size(), 0);
+            FREUD_STAT(++counters.read_calls);
+            if (result < 0 && (errno == ENOSYS || errno == EPERM)) {
+                return false;
+            } else if (result < 0 && errno == ESRCH) {
+                // The target has exited, so nothing else will be readable
+                for (std::size_t i = next; i < requests.size(); ++i) {
+                    requests[i].bytes_read = 0;
+                    std::memset(requests[i].buffer, 0, requests[i].size);
+                    add_failed_range(failed, requests[i].address,
+                                     requests[i].address + requests[i].size);
+                }
+                return true;
+            }
+
+            std::size_t transferred = result > 0 ? result : 0;
+            std::size_t i = next;
+            for (; i < next + local.size(); ++i) {
+                ReadRequest& request = requests[i];
+                if (transferred >= request.size) {
+                    request.bytes_read = request.size;
+                    transferred -= request.size;
+                    continue;
+                }
+
+                // This request was the first to fail. Recover what we can
+                // from it and restart the batch with the following request.
+                request.bytes_read = transferred;
+                read_remainder_by_page(*this, request, failed, counters);
+                ++i;
+                break;
+            }
+            next = i;
+        }
+        return true;
+    }
+
+private:
+    pid_t m_pid;
+};
+}
+}
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef FREUD_LOCAL_MEMORY_CONTEXT
+#define FREUD_LOCAL_MEMORY_CONTEXT
+
+#include "freud/AlignedBuffer.hpp"
+#include "freud/FaultGuard.hpp"
+#include "freud/LinuxMaps.hpp"
+#include "freud/LinuxReadBackend.hpp"
+#include "freud/MemoryContext.hpp"
+#include "freud/ParallelScan.hpp"
+#include "freud/RangeScan.hpp"
+
+namespace freud {
+
+/** \brief A memory context for the process that freud is running in
+ *
+ * This is useful when freud is embedded in the target as a diagnostics
+ * agent. The regions are read from /proc/self/maps (only readable regions
+ * are included), and the memory is accessed directly rather than through
+ * system calls:
+ *
+ * - Scans (by iterators, `scan_parallel` and the other scanners) copy each
+ *   window of a region with `safe_copy` before checking it, and skip the
+ *   rest of a region that can no longer be read.
+ * - `read` and `read_batch` copy the bytes with `safe_copy`, which returns
+ *   false rather than crashing if the memory is not readable. These are
+ *   safe to use from a verifier following pointers that may be invalid.
+ *
+ * The host may unmap memory at any time (with `munmap` or `malloc_trim`,
+ * or by truncating a mapped file), so nothing is read without that
+ * protection by default. If the regions cannot change while they are
+ * scanned, `set_direct_views(true)` makes scans read them in place,
+ * without copying them. A region unmapped during such a scan crashes the
+ * process.
+ *
+ * Note that the scan will find the objects that freud itself holds (such
+ * as the object most recently returned by an iterator), as they are part
+ * of the same address space.
+ */
+class LocalMemoryContext : public BaseMemoryContext<LocalMemoryContext> {
+public:
+    /// Create a context for the readable regions accepted by 'filter'
+    explicit LocalMemoryContext(const RegionFilter& filter = RegionFilter())
+        : BaseMemoryContext(), m_filter(filter),
+          m_window_size(default_window_size), m_direct_views(false) {
+        m_filter.require(REGION_READ);
+        update_regions();
+    }
+
+    ~LocalMemoryContext() {}
+
+    /// Copy 'buffer.size()' bytes starting at 'address'
+    bool read(address_t address, std::vector<char>& buffer) const {
+        if (buffer.empty()) {
+            return true;
+        }
+        return copy(address, reinterpret_cast<byte_t*>(&buffer[0]),
+                    buffer.size());
+    }
+
+    bool
+    read(address_t address, std::vector<char>& buffer,
+         std::vector<BaseMemoryContext::MemoryRegion>::const_iterator) const {
+        return read(address, buffer);
+    }
+
+    /// Read a T from 'address' (see LinuxMemoryContext::read)
+    template <typename T>
+    T read(address_t address, bool* ok = NULL) const {
+        detail::ObjectStorage<T> storage;
+        const bool result = copy(address, storage.bytes, sizeof(T));
+        if (!result) {
+            std::memset(storage.bytes, 0, sizeof(T));
+        }
+        if (ok) {
+            *ok = result;
+        }
+        return storage.get();
+    }
+
+    /// Get a pointer to the bytes [address, address + size)
+    /**
+     * \returns NULL if the bytes do not lie within a single region, or if
+     *          direct views are disabled
+     */
+    const byte_t* data(address_t address, std::size_t size) const {
+        if (!m_direct_views) {
+            return NULL;
+        }
+        std::vector<MemoryRegion>::const_iterator iter =
+            region_containing(address);
+        if (iter == mapped_regions().end() ||
+            size > iter->end_address - address) {
+            return NULL;
+        }
+        return reinterpret_cast<const byte_t*>(address);
+    }
+
+    /// Get a pointer to the bytes from 'address' onwards in the region
+    /// described by 'iter'
+    /**
+     * With direct views, 'data' is simply 'address' and 'available' is the
+     * number of bytes until the end of the region. Otherwise, the next
+     * window of the region is copied into the context first. The pointer
+     * remains valid until the next call to `view` or `update_regions`.
+     */
+    bool view(address_t address,
+              std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+              const byte_t*& data, std::size_t& available,
+              std::size_t size = 1) {
+        if (address < iter->start_address || address >= iter->end_address) {
+            return false;
+        }
+        if (m_direct_views) {
+            data = reinterpret_cast<const byte_t*>(address);
+            available = iter->end_address - address;
+            return true;
+        }
+
+        address_t end = address + (size > m_window_size ? size : m_window_size);
+        if (end > iter->end_address || end < address) {
+            end = iter->end_address;
+        }
+        m_window.resize(end - address);
+        if (!copy(address, m_window.data(), m_window.size())) {
+            m_window.clear();
+            return false;
+        }
+        data = m_window.data();
+        available = m_window.size();
+        return true;
+    }
+
+    /// Copy several (possibly discontiguous) ranges at once
+    /**
+     * This behaves like `LinuxMemoryContext::read_batch`. Pages that cannot
+     * be read are zero-filled and reported in 'failed'.
+     *
+     * \returns true if every request was read completely
+     */
+    bool read_batch(std::vector<ReadRequest>& requests,
+                    std::vector<FailedRange>* failed = NULL,
+                    ScanCounters* counters = NULL) const {
+        ScanCounters work;
+        bool result = true;
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            ReadRequest& request = requests[i];
+            request.bytes_read = 0;
+            if (detail::safe_copy(request.buffer,
+                                  reinterpret_cast<const byte_t*>(
+                                      request.address),
+                                  request.size)) {
+                request.bytes_read = request.size;
+            } else {
+                copy_by_page(request, failed);
+                result = false;
+                FREUD_STAT(++work.failed_reads);
+            }
+            FREUD_STAT(work.bytes_requested += request.size);
+            FREUD_STAT(work.bytes_read += request.bytes_read);
+        }
+        FREUD_STAT(m_read_counters.add(work));
+        FREUD_STAT(if (counters) { counters->add(work); });
+        return result;
+    }
+
+    /// Scan the process for MemObjects using several threads
+    /**
+     * This behaves like `LinuxMemoryContext::scan_parallel`. With direct
+     * views, the regions are scanned in place.
+     *
+     * \returns The number of matches found
+     */
+    template <typename MemObject, typename Callback>
+    std::size_t
+    scan_parallel(unsigned threads, Callback callback, bool ordered = false,
+                  std::size_t chunk_size = default_parallel_chunk_size,
+                  ScanStats* stats = NULL) const {
+        detail::ParallelScan<MemObject, const LocalMemoryContext, Callback>
+            scan(*this, callback, ordered);
+        return scan.run(threads, chunk_size, stats);
+    }
+
+    /// True if scans read the regions in place
+    bool direct_views() const { return m_direct_views; }
+
+    /// Choose whether scans read the regions in place or copy them with
+    /// `safe_copy` first (the default)
+    void set_direct_views(bool enabled) {
+        m_direct_views = enabled;
+        m_window.clear();
+    }
+
+    /// The number of bytes copied at once by a view when direct views are
+    /// disabled
+    std::size_t window_size() const { return m_window_size; }
+
+    void set_window_size(std::size_t size) {
+        m_window_size = size == 0 ? 1 : size;
+        m_window.clear();
+    }
+
+    /// The filter selecting which regions are scanned
+    const RegionFilter& region_filter() const { return m_filter; }
+
+    /// Change the region filter. The regions are updated immediately.
+    void set_region_filter(const RegionFilter& filter) {
+        m_filter = filter;
+        m_filter.require(REGION_READ);
+        update_regions();
+    }
+
+    void update_regions() {
+        m_window.clear();
+        std::vector<MemoryRegion> regions;
+        if (detail::read_whole_file("/proc/self/maps", m_maps_contents)) {
+            detail::parse_maps(m_maps_contents, m_filter, regions);
+        }
+
+        // Some of the kernel's [vvar] pages fault when they are read, even
+        // though the region is marked readable
+        std::vector<MemoryRegion>::iterator out = regions.begin();
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            if (regions[i].name.compare(0, 5, "[vvar") != 0) {
+                *out++ = regions[i];
+            }
+        }
+        regions.erase(out, regions.end());
+        publish_regions(regions);
+    }
+
+private:
+    LocalMemoryContext(const LocalMemoryContext&);
+    LocalMemoryContext& operator=(const LocalMemoryContext&);
+
+    static const std::size_t default_window_size = 1024 * 1024;
+
+    /// Copy 'size' bytes at 'address', counting the work done
+    bool copy(address_t address, byte_t* out, std::size_t size) const {
+        const bool result = detail::safe_copy(
+            out, reinterpret_cast<const byte_t*>(address), size);
+        ScanCounters work;
+        FREUD_STAT(work.bytes_requested += size);
+        FREUD_STAT(work.bytes_read += result ? size : 0);
+        FREUD_STAT(work.failed_reads += result ? 0 : 1);
+        FREUD_STAT(m_read_counters.add(work));
+        return result;
+    }
+
+    /// Copy a request one page at a time, zero filling the pages that
+    /// cannot be read
+    static void copy_by_page(ReadRequest& request,
+                             std::vector<FailedRange>* failed) {
+        const std::size_t page = detail::page_size();
+        const address_t end = request.address + request.size;
+        for (address_t address = request.address; address < end;) {
+            address_t page_end = (address & ~(page - 1)) + page;
+            if (page_end > end || page_end < address) {
+                page_end = end;
+            }
+            byte_t* dest = request.buffer + (address - request.address);
+            if (detail::safe_copy(dest,
+                                  reinterpret_cast<const byte_t*>(address),
+                                  page_end - address)) {
+                request.bytes_read += page_end - address;
+            } else {
+                std::memset(dest, 0, page_end - address);
+                detail::add_failed_range(failed, address, page_end);
+            }
+            address = page_end;
+        }
+    }
+
+    RegionFilter m_filter;
+    std::string m_maps_contents;
+
+    // The bytes copied by the last view, when direct views are disabled
+    detail::AlignedBuffer m_window;
+    std::size_t m_window_size;
+    bool m_direct_views;
+};
+
+namespace detail {
+
+template <>
+struct InPlaceAccess<const LocalMemoryContext> {
+    static const byte_t* data(const LocalMemoryContext& ctx,
+                              address_t address, std::size_t size) {
+        return ctx.data(address, size);
+    }
+};
+
+template <>
+struct InPlaceAccess<LocalMemoryContext>
+    : public InPlaceAccess<const LocalMemoryContext> {};
+}
+}
+
+#endif
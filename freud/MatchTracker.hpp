@@ -0,0 +1,250 @@
+#ifndef FREUD_MATCH_TRACKER
+#define FREUD_MATCH_TRACKER
+
+#include "freud/MemoryContext.hpp"
+#include "freud/MemoryContextIterator.hpp"
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace freud {
+
+/// The kinds of change reported by a MatchTracker
+enum MatchEvent {
+    /// The address matches, but did not match in the previous pass
+    MATCH_APPEARED,
+
+    /// The address matched in the previous pass, but the object's bytes
+    /// are different
+    MATCH_CHANGED,
+
+    /// The address matched in the previous pass, but does not match now
+    MATCH_DISAPPEARED
+};
+
+/** \brief Tracks the matches of a continuous scan across passes
+ *
+ * Rather than reporting every match on every pass, a MatchTracker compares
+ * each pass with the previous one and reports only the differences. For
+ * every change, `callback(event, address, object)` is invoked, where
+ * 'object' points to the current object, or is NULL for a
+ * MATCH_DISAPPEARED event. Objects whose bytes did not change are not
+ * reported. For example:
+ *
+ * \code{.c}
+ * struct PrintChanges {
+ *   void operator()(MatchEvent event, address_t address,
+ *                   const Position* p) {
+ *     ...
+ *   }
+ * };
+ *
+ * MatchTracker<PositionMatcher> tracker;
+ * for (;;) {
+ *   tracker.scan(ctx, PrintChanges());
+ * }
+ * \endcode
+ *
+ * Changes are detected by comparing a 64-bit hash of the object's bytes,
+ * so the tracker only stores 16 bytes for each address that currently
+ * matches (and forgets an address once it disappears). The number of
+ * tracked addresses can also be limited with set_max_matches.
+ *
+ * The matches of a pass can also come from another source, such as an
+ * IncrementalScanner or scan_parallel, by calling begin_pass, passing
+ * each match to the Sink returned by `sink` and then calling end_pass.
+ * Matches are handled fastest when they are in increasing address order.
+ */
+template <typename MemObject>
+class MatchTracker {
+public:
+    typedef typename MemObject::type type;
+
+    MatchTracker() : m_max_matches(0), m_dropped(0), m_cursor(0) {}
+
+    /// Perform one pass over a context, reporting the changes since the
+    /// previous pass
+    /**
+     * The context's mapped regions are updated first (like a
+     * `scan_forever` iterator starting a new pass). Other iterators into
+     * the context keep scanning the version of the regions they started
+     * with.
+     *
+     * \returns The number of matches in this pass
+     */
+    template <typename Context, typename Callback>
+    std::size_t scan(Context& ctx, Callback callback) {
+        ctx.update_regions();
+        begin_pass();
+        std::size_t matches = 0;
+        MemoryContextIterator<MemObject, Context> iter =
+            ctx.template scan_once<MemObject>();
+        for (; iter != ctx.end(); ++iter, ++matches) {
+            match(iter.address(), *iter, callback);
+        }
+        end_pass(callback);
+        return matches;
+    }
+
+    /// Start a pass
+    void begin_pass() {
+        m_current.clear();
+        m_seen.assign(m_previous.size(), false);
+        m_cursor = 0;
+        m_dropped = 0;
+    }
+
+    /// Record a match of the current pass, reporting it if it appeared or
+    /// changed since the previous pass
+    template <typename Callback>
+    void match(address_t address, const type& object, Callback& callback) {
+        const Entry entry = {address, hash(object)};
+
+        const std::size_t found = find_previous(address);
+        if (found == m_previous.size()) {
+            if (m_max_matches != 0 &&
+                m_current.size() >= m_max_matches) {
+                ++m_dropped;
+                return;
+            }
+            m_current.push_back(entry);
+            callback(MATCH_APPEARED, address, &object);
+            return;
+        }
+
+        if (m_seen[found]) {
+            // The same address was matched twice in this pass
+            return;
+        }
+        m_seen[found] = true;
+        m_current.push_back(entry);
+        if (m_previous[found].hash != entry.hash) {
+            callback(MATCH_CHANGED, address, &object);
+        }
+    }
+
+    /// Finish a pass, reporting the matches of the previous pass that were
+    /// not seen in this one
+    template <typename Callback>
+    void end_pass(Callback& callback) {
+        for (std::size_t i = 0; i < m_previous.size(); ++i) {
+            if (!m_seen[i]) {
+                callback(MATCH_DISAPPEARED, m_previous[i].address,
+                         static_cast<const type*>(NULL));
+            }
+        }
+
+        std::sort(m_current.begin(), m_current.end(), &address_less);
+        m_current.erase(std::unique(m_current.begin(), m_current.end(),
+                                    &same_address),
+                        m_current.end());
+        m_previous.swap(m_current);
+        m_current.clear();
+        m_seen.clear();
+    }
+
+    /// A sink passing the matches of a pass to a tracker
+    template <typename Callback>
+    struct Sink {
+        MatchTracker* tracker;
+        Callback* callback;
+
+        bool operator()(address_t address, const type& object) {
+            tracker->match(address, object, *callback);
+            return true;
+        }
+    };
+
+    /// Get a sink that records matches of the current pass with 'callback'
+    template <typename Callback>
+    Sink<Callback> sink(Callback& callback) {
+        Sink<Callback> result = {this, &callback};
+        return result;
+    }
+
+    /// The number of addresses that matched in the last finished pass
+    std::size_t size() const { return m_previous.size(); }
+
+    /// Limit the number of tracked addresses (0, the default, means no
+    /// limit)
+    /**
+     * Once the limit is reached, new matches are ignored until tracked
+     * addresses disappear. See dropped.
+     */
+    void set_max_matches(std::size_t matches) { m_max_matches = matches; }
+
+    /// The number of new matches ignored in the current (or last) pass
+    /// because of the limit set by set_max_matches
+    std::size_t dropped() const { return m_dropped; }
+
+    /// Forget every tracked address, so the next pass reports every match
+    /// as new
+    void clear() {
+        m_previous.clear();
+        m_current.clear();
+        m_seen.clear();
+    }
+
+private:
+    struct Entry {
+        address_t address;
+        uint64_t hash;
+    };
+
+    static bool address_less(const Entry& left, const Entry& right) {
+        return left.address < right.address;
+    }
+
+    static bool same_address(const Entry& left, const Entry& right) {
+        return left.address == right.address;
+    }
+
+    static bool entry_before(const Entry& entry, address_t address) {
+        return entry.address < address;
+    }
+
+    /// FNV-1a
+    static uint64_t hash(const type& object) {
+        const byte_t* bytes = reinterpret_cast<const byte_t*>(&object);
+        uint64_t result = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < sizeof(type); ++i) {
+            result = (result ^ bytes[i]) * 1099511628211ULL;
+        }
+        return result;
+    }
+
+    /// The index of 'address' in the previous pass, or m_previous.size()
+    std::size_t find_previous(address_t address) {
+        // Matches usually arrive in address order, so start searching from
+        // the last match
+        typedef typename std::vector<Entry>::const_iterator EntryIter;
+        const std::vector<Entry>& previous = m_previous;
+        EntryIter begin = previous.begin();
+        if (m_cursor < previous.size() &&
+            previous[m_cursor].address <= address) {
+            begin += m_cursor;
+        }
+        EntryIter iter =
+            std::lower_bound(begin, previous.end(), address, &entry_before);
+        m_cursor = iter - previous.begin();
+        if (iter == previous.end() || iter->address != address) {
+            return previous.size();
+        }
+        return m_cursor;
+    }
+
+    // The matches of the last finished pass, in address order, and
+    // whether each one has been seen in the current pass
+    std::vector<Entry> m_previous;
+    std::vector<bool> m_seen;
+
+    // The matches of the current pass
+    std::vector<Entry> m_current;
+
+    std::size_t m_max_matches;
+    std::size_t m_dropped;
+    std::size_t m_cursor;
+};
+}
+
+#endif
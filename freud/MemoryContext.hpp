@@ -2,13 +2,17 @@
 #define FREUD_MEMORY_CONTEXT
 
 #include "freud/Defines.hpp"
+#include "freud/RegionTable.hpp"
+#include "freud/RegionFilter.hpp"
+#include "freud/ScanStats.hpp"
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
 
 namespace freud {
 
-template <typename T>
+template <typename T, typename Context>
 class MemoryContextIterator;
 
 /**
@@ -38,8 +42,28 @@ public:
 
         /// The ending virtual address of the region
         address_t end_address;
+
+        /// The RegionPermission flags of the region
+        unsigned permissions;
+
+        /// The offset of the region in the mapped file (if any)
+        address_t offset;
+
+        /// The inode of the mapped file (or 0 if the region is not a file)
+        unsigned long inode;
     };
 
+    /// One version of the context's mapped regions
+    typedef detail::RegionTable<MemoryRegion> RegionTable;
+
+    /// A counted reference to a RegionTable
+    typedef detail::RegionTableRef<MemoryRegion> RegionTableRef;
+
+    BaseMemoryContext() : m_region_stats(false) {
+        std::vector<MemoryRegion> regions;
+        m_table = RegionTableRef(new RegionTable(regions, 0));
+    }
+
     ~BaseMemoryContext() {}
 
     /// Create a non-continuous (single-pass) iterator into this context
@@ -48,28 +72,27 @@ public:
      * single-pass iterators may traverse a memory context simultaneously.
      */
     template <typename MemObject>
-    MemoryContextIterator<MemObject> scan_once() {
-        return MemoryContextIterator<MemObject>(
+    MemoryContextIterator<MemObject, Context> scan_once() {
+        return MemoryContextIterator<MemObject, Context>(
             *reinterpret_cast<Context*>(this));
     }
 
     /// Create a continuous iterator into this context
     /**
-     * 'MemObject' must be a type derived from MemoryObject. Note that
-     * incrementing a continuous MemoryContextIterator will invalidate
-     * all other iterators into this context.
+     * 'MemObject' must be a type derived from MemoryObject. Each time the
+     * iterator wraps around, the context's regions are updated. Other
+     * iterators keep using the version of the regions they started with.
      */
     template <typename MemObject>
-    MemoryContextIterator<MemObject> scan_forever() {
-        return MemoryContextIterator<MemObject>(*reinterpret_cast<Context*>(
-                                                    this),
-                                                true);
+    MemoryContextIterator<MemObject, Context> scan_forever() {
+        return MemoryContextIterator<MemObject, Context>(
+            *reinterpret_cast<Context*>(this), true);
     }
 
     /// Retrieve an iterator to the end of the context
     template <typename MemObject>
-    MemoryContextIterator<MemObject> end() const {
-        return MemoryContextIterator<MemObject>();
+    MemoryContextIterator<MemObject, Context> end() const {
+        return MemoryContextIterator<MemObject, Context>();
     }
 
     /// Retrieve an iterator to the end of the context. This iterator may be
@@ -78,10 +101,34 @@ public:
 
     /// A collection of MemoryRegions representing the known valid addresses in
     /// this context
+    /**
+     * The reference is only valid until the regions are next updated. Use
+     * region_table to keep a version of the regions for longer.
+     */
     const std::vector<MemoryRegion>& mapped_regions() const {
-        return m_regions;
+        return m_table->regions();
     }
 
+    /// The current version of the mapped regions
+    /**
+     * The table never changes, and stays valid for as long as a reference
+     * to it is held, even if the context's regions are updated. Unlike the
+     * other functions describing the regions, this may be called while
+     * another thread updates them.
+     */
+    RegionTableRef region_table() const {
+        detail::SpinLockGuard guard(m_table_lock);
+        return m_table;
+    }
+
+    /// The version of the mapped regions, which increases every time an
+    /// update finds that the regions have changed
+    unsigned long regions_version() const { return m_table->version(); }
+
+    /// The differences between the previous version of the mapped regions
+    /// and the current one
+    const RegionChanges& region_changes() const { return m_region_changes; }
+
     /// Retrieve an iterator to the MemoryRegion containing the given address
     /**
      * \param address The region containing this address will be returned
@@ -90,18 +137,78 @@ public:
      */
     typename std::vector<MemoryRegion>::const_iterator
     region_containing(address_t address) const {
-        for (typename std::vector<MemoryRegion>::const_iterator iter =
-                 m_regions.begin();
-             iter != m_regions.end(); ++iter) {
-            if (address >= iter->start_address && address < iter->end_address) {
-                return iter;
-            }
-        }
-        return m_regions.end();
+        return m_table->region_containing(address);
+    }
+
+    /// Test whether an address is in any mapped region
+    bool contains_address(address_t address) const {
+        return region_containing(address) != mapped_regions().end();
     }
 
+    /// Test whether an address is in the heap or an anonymous mapping
+    /**
+     * These are the regions that dynamically allocated objects live in, so
+     * this is a stricter (and slightly faster) test for pointers to such
+     * objects than contains_address.
+     */
+    bool in_heap_or_anonymous(address_t address) const {
+        return m_table->in_heap_or_anonymous(address);
+    }
+
+    /// The reads made by this context since it was created (or since
+    /// reset_read_counters was called)
+    /**
+     * Only the bytes_requested, bytes_read, read_calls and failed_reads
+     * counters are filled in. Reads made by every iterator and scan of the
+     * context (and by background prefetching) are included.
+     */
+    ScanCounters read_counters() const { return m_read_counters.get(); }
+
+    /// Reset the counters returned by read_counters
+    void reset_read_counters() { m_read_counters.reset(); }
+
+    /// Collect a per-region breakdown in the ScanStats of later scans
+    void set_region_stats(bool enabled) { m_region_stats = enabled; }
+
+    /// True if scans collect a per-region breakdown of their ScanStats
+    bool region_stats() const { return m_region_stats; }
+
 protected:
-    std::vector<MemoryRegion> m_regions;
+    // Updated by the context's read functions (including const ones)
+    mutable detail::SharedReadCounters m_read_counters;
+    bool m_region_stats;
+
+    /// Replace the mapped regions with the contents of 'regions', which
+    /// must be sorted by address
+    /**
+     * If the regions differ from the current ones, a new RegionTable is
+     * built and replaces the current one in a single step, under the lock
+     * that region_table takes, so a reference copied by another thread is
+     * always to a live table. Otherwise, the current table is kept, along
+     * with its version.
+     *
+     * \returns true if the regions changed
+     */
+    bool publish_regions(std::vector<MemoryRegion>& regions) {
+        RegionChanges changes;
+        m_table->diff(regions, changes);
+        m_region_changes = changes;
+        if (changes.empty()) {
+            return false;
+        }
+        // The old table is released by 'table' after the lock is dropped
+        RegionTableRef table(new RegionTable(regions, regions_version() + 1));
+        {
+            detail::SpinLockGuard guard(m_table_lock);
+            m_table.swap(table);
+        }
+        return true;
+    }
+
+private:
+    RegionTableRef m_table;
+    mutable detail::SpinLock m_table_lock;
+    RegionChanges m_region_changes;
 };
 }
 
@@ -1,38 +1,51 @@
 #ifndef FREUD_MEMORY_CONTEXT_ITERATOR
 #define FREUD_MEMORY_CONTEXT_ITERATOR
 
+#include "freud/AlignedBuffer.hpp"
 #include "freud/Alignment.hpp"
 #include "freud/MemoryContext.hpp"
+#include "freud/ScanKernel.hpp"
 #include <iterator>
 
 namespace freud {
 
 /** \brief An iterator into some MemoryContext
+ *
+ * 'Context' is the type of context being scanned. It defaults to the
+ * MemoryContext of the current platform, but may be any context derived
+ * from BaseMemoryContext (a SnapshotMemoryContext, for example).
  *
  * MemoryContextIterators apply a typed view onto a MemoryContext. When
  * dereferenced, the iterator returns a reference to an instance of
  * the MemObject::type for which MemObject::verify returns true.
+ *
+ * Candidates are checked in place, in the context's cached window of the
+ * region being scanned. Only matching objects are copied, into storage held by
+ * the iterator itself, so copying an iterator does not allocate (unless the
+ * context collects per-region statistics).
  */
-template <typename MemObject>
+template <typename MemObject, typename Context = MemoryContext>
 class MemoryContextIterator : public std::iterator<std::forward_iterator_tag,
                                                    typename MemObject::type> {
 public:
     /// Default constructor for the iterator
-    MemoryContextIterator() : m_address(0) {}
+    MemoryContextIterator() : m_ctx(NULL), m_address(0), m_next(0) {}
 
     /**
      * \param ctx The context this iterator iterates over
      * \param continuous If this parameter is 'true', the context's mapped
-     *                   regions are updated (invalidating other iterators).
+     *                   regions are updated each time the iterator reaches
+     *                   the end of the context.
      */
-    MemoryContextIterator(MemoryContext& ctx, bool continuous = false)
+    MemoryContextIterator(Context& ctx, bool continuous = false)
         : m_ctx(&ctx),
-          m_iter(m_ctx->mapped_regions().begin()),
+          m_table(ctx.region_table()),
+          m_iter(m_table->regions().begin()),
           m_address(0),
-          m_bytes(sizeof(typename MemObject::type)),
+          m_next(0),
           m_continuous(continuous) {
-        if (m_ctx->mapped_regions().size() > 0) {
-            m_address = m_iter->start_address;
+        if (m_table->regions().size() > 0) {
+            m_next = m_iter->start_address;
         }
         this->increment();
     }
@@ -65,81 +78,173 @@ public:
 
     /// Test if this is a continuous iterator.
     /**
-     * If the iterator is continuous, the context's mapped, the corresponding
-     * memory context's regions are updated when the end of the context is
-     * reached (invalidating other iterators).
+     * If the iterator is continuous, the memory context's regions are
+     * updated when the end of the context is reached. Other iterators keep
+     * scanning the version of the regions they started with.
      */
     bool continuous() const { return m_continuous; }
 
     /// Get the current address in the memory context's address space
     address_t address() const { return m_address; }
 
+    /// The statistics of the scan so far
+    /**
+     * Time is only counted while the iterator is searching for the next
+     * match, so it does not include the time spent by the caller between
+     * increments. The read counters are taken from the context, so they
+     * also include reads made by other users of the context in the
+     * meantime. For a continuous iterator, the per-region breakdown only
+     * covers the current pass over the context.
+     */
+    ScanStats stats() const {
+        ScanStats stats = m_stats;
+        stats.add(m_region);
+        stats.wall_seconds = stats.seconds;
+        return stats;
+    }
+
 private:
+    typedef typename MemObject::type type;
+
+    /// Copies the first match out of the context's cache and stops the scan
+    struct YieldSink {
+        MemoryContextIterator* iter;
+        bool found;
+
+        bool operator()(address_t address, const type& object) {
+            std::memcpy(iter->m_object.bytes, &object, sizeof(type));
+            iter->m_address = address;
+            FREUD_STAT(++iter->m_region.matches);
+            found = true;
+            return false;
+        }
+    };
+
     void increment() {
-        while (m_iter != m_ctx->mapped_regions().end()) {
-            if (m_ctx->read(m_address, m_bytes, m_iter)) {
-                m_address +=
-                    detail::alignment_of<typename MemObject::type>::value;
-                if (m_address >= m_iter->end_address) {
-                    m_iter++;
-                    if (m_iter == m_ctx->mapped_regions().end())
-                        break;
-                    m_address = m_iter->start_address;
+        FREUD_STAT(start_measuring());
+        for (;;) {
+            while (m_iter != m_table->regions().end()) {
+                const byte_t* data;
+                std::size_t available;
+                bool viewed = m_next < m_iter->end_address &&
+                              m_ctx->view(m_next, m_iter, data, available,
+                                          sizeof(type));
+                if (viewed && available >= sizeof(type)) {
+                    // Only objects that lie entirely within the view are
+                    // checked. The rest are checked in the next view.
+                    YieldSink sink = {this, false};
+                    m_next += detail::ScanKernel<MemObject>::scan(
+                        *m_ctx, data, available, m_next, 0,
+                        available - sizeof(type) + 1, sink, &m_region);
+                    if (sink.found) {
+                        FREUD_STAT(stop_measuring());
+                        return;
+                    }
+                    continue;
                 }
 
-                MemObject::before_check();
-                if (!MemObject::verify(*m_ctx, this->dereference(),
-                                       m_address)) {
-                    continue;
+                // If the view failed, the rest of the region is skipped
+                FREUD_STAT(finish_region(!viewed &&
+                                         m_next < m_iter->end_address));
+                m_iter++;
+                if (m_iter != m_table->regions().end()) {
+                    m_next = m_iter->start_address;
                 }
+            }
+
+            if (!reached_end_of_context()) {
+                FREUD_STAT(stop_measuring());
                 return;
-            } else {
-                m_iter++;
-                if (m_iter == m_ctx->mapped_regions().end())
-                    break;
-                m_address = m_iter->start_address;
             }
         }
-        reached_end_of_context();
     }
 
-    const typename MemObject::type& dereference() const {
-        return *reinterpret_cast<const typename MemObject::type*>(
-            &*m_bytes.begin());
+    void start_measuring() {
+        m_mark_time = detail::stats_clock();
+        m_mark_reads = m_ctx->read_counters();
     }
 
-    template <typename T>
-    friend bool operator==(const MemoryContextIterator<T>& left,
+    /// Add the time and reads since start_measuring to the current region
+    void stop_measuring() {
+        m_region.seconds += detail::stats_clock() - m_mark_time;
+        detail::add_read_delta(m_region, m_mark_reads, m_ctx->read_counters());
+    }
+
+    void finish_region(bool skipped) {
+        stop_measuring();
+        RegionStats region;
+        static_cast<ScanCounters&>(region) = m_region;
+        region.start_address = m_iter->start_address;
+        region.end_address = m_iter->end_address;
+        region.skipped = skipped;
+
+        m_stats.add(region);
+        m_stats.regions_skipped += skipped ? 1 : 0;
+        if (m_ctx->region_stats()) {
+            m_stats.regions.push_back(region);
+        }
+        m_region = ScanCounters();
+        start_measuring();
+    }
+
+    const type& dereference() const { return m_object.get(); }
+
+    template <typename T, typename C>
+    friend bool operator==(const MemoryContextIterator<T, C>& left,
                            MemoryContextEndIterator right);
 
-    void reached_end_of_context() {
+    /// Returns true if the scan should start again from the beginning
+    bool reached_end_of_context() {
         if (!continuous()) {
             m_address = 0;
-        } else {
-            m_ctx->update_regions();
-            m_iter = m_ctx->mapped_regions().begin();
-            if (m_ctx->mapped_regions().size() > 0) {
-                m_address = m_iter->start_address;
-            }
-            this->increment();
+            return false;
         }
+        m_ctx->update_regions();
+        m_stats.regions.clear();
+        m_table = m_ctx->region_table();
+        m_iter = m_table->regions().begin();
+        if (m_table->regions().size() > 0) {
+            m_next = m_iter->start_address;
+        }
+        return true;
     }
 
-    MemoryContext* m_ctx;
-    typename std::vector<MemoryContext::MemoryRegion>::const_iterator m_iter;
+    Context* m_ctx;
+
+    // The version of the context's regions being scanned, which is kept
+    // alive for as long as the iterator uses it
+    typename Context::RegionTableRef m_table;
+    typename std::vector<typename Context::MemoryRegion>::const_iterator
+        m_iter;
+
+    // The address of the current match (or 0 at the end of the context)
     address_t m_address;
-    std::vector<char> m_bytes;
+
+    // The address of the next candidate to be checked
+    address_t m_next;
+
+    detail::ObjectStorage<type> m_object;
     bool m_continuous;
+
+    // The statistics of the regions that have been finished, and of the
+    // current region
+    ScanStats m_stats;
+    ScanCounters m_region;
+
+    // The state of the clock and the context's counters when the iterator
+    // started its current search
+    double m_mark_time;
+    ScanCounters m_mark_reads;
 };
 
-template <typename T>
-bool operator==(const MemoryContextIterator<T>& left,
+template <typename T, typename C>
+bool operator==(const MemoryContextIterator<T, C>& left,
                 MemoryContextEndIterator) {
     return left.m_address == 0;
 }
 
-template <typename T>
-bool operator!=(const MemoryContextIterator<T>& left,
+template <typename T, typename C>
+bool operator!=(const MemoryContextIterator<T, C>& left,
                 MemoryContextEndIterator right) {
     return !(left == right);
 }
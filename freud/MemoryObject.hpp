@@ -1,6 +1,10 @@
 #ifndef FREUD_MEMORY_OBJECT
 #define FREUD_MEMORY_OBJECT
 
+#include "freud/Anchor.hpp"
+#include "freud/BatchVerify.hpp"
+#include <vector>
+
 namespace freud {
 
 /** \brief The base class for all MemoryObjects
@@ -26,6 +30,41 @@ namespace freud {
  *   }
  * }
  * \endcode
+ *
+ * If every instance of the type has some fields with known values, the
+ * MemoryObject may also declare them as anchors. Scans then only call
+ * 'verify' for objects containing those values, which is usually much
+ * faster than calling it at every offset:
+ *
+ * \code{.c}
+ * class PositionMatcher : public MemoryObject<Position> {
+ *   static void anchors(std::vector<Anchor>& out) {
+ *     out.push_back(make_anchor(offsetof(Position, x), 10));
+ *   }
+ *   ...
+ * }
+ * \endcode
+ *
+ * A MemoryObject may also define a 'verify_batch' hook, which checks up
+ * to verify_batch_size candidates in one call and returns a mask with
+ * bit 'i' set if the object at `data + offsets[i]` (at address
+ * `base + offsets[i]`) matches. Scans then use it instead of 'verify'.
+ * Gathering the fields that are checked into arrays lets the compiler
+ * compare several candidates at once:
+ *
+ * \code{.c}
+ * class PositionMatcher : public MemoryObject<Position> {
+ *   template <typename Context>
+ *   static uint64_t verify_batch(const Context&, const byte_t* data,
+ *                                address_t, const std::size_t* offsets,
+ *                                std::size_t count) {
+ *     int x[verify_batch_size];
+ *     gather_field(data, offsets, count, offsetof(Position, x), x);
+ *     return equal_mask(x, count, 10);
+ *   }
+ *   ...
+ * }
+ * \endcode
  */
 template <typename T>
 class MemoryObject {
@@ -33,6 +72,7 @@ public:
     typedef T type;
     static bool verify(const T&) { return true; }
     static void before_check() {}
+    static void anchors(std::vector<Anchor>&) {}
 };
 }
 
@@ -0,0 +1,369 @@
+#ifndef FREUD_MULTI_PROCESS_SCANNER
+#define FREUD_MULTI_PROCESS_SCANNER
+
+#include "freud/LinuxMaps.hpp"
+#include "freud/LinuxMemoryContext.hpp"
+#include "freud/ParallelScan.hpp"
+#include "freud/RangeScan.hpp"
+#include "freud/ThreadPool.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <dirent.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace freud {
+
+/// The part of a process's description matched by find_processes
+enum ProcessField {
+    /// The executable name, from /proc/<pid>/comm (at most 15 characters)
+    PROCESS_COMM,
+
+    /// The command line, from /proc/<pid>/cmdline, with its arguments
+    /// separated by spaces
+    PROCESS_CMDLINE
+};
+
+namespace detail {
+
+inline bool process_matches(unsigned long pid, const std::string& pattern,
+                            ProcessField field) {
+    std::ostringstream path;
+    path << "/proc/" << pid
+         << (field == PROCESS_COMM ? "/comm" : "/cmdline");
+    std::string contents;
+    if (!read_whole_file(path.str().c_str(), contents)) {
+        return false;
+    }
+
+    if (field == PROCESS_COMM) {
+        if (!contents.empty() && contents[contents.size() - 1] == '\n') {
+            contents.erase(contents.size() - 1);
+        }
+        if (!pattern.empty() && pattern[pattern.size() - 1] == '*') {
+            return contents.compare(0, pattern.size() - 1, pattern, 0,
+                                    pattern.size() - 1) == 0;
+        }
+        return contents == pattern;
+    }
+
+    // Kernel threads have an empty command line
+    if (contents.empty()) {
+        return false;
+    }
+    if (contents[contents.size() - 1] == '\0') {
+        contents.erase(contents.size() - 1);
+    }
+    std::replace(contents.begin(), contents.end(), '\0', ' ');
+    return contents.find(pattern) != std::string::npos;
+}
+
+/// Test whether a process exists and has not exited (a zombie process has
+/// exited, but still exists until it is reaped)
+inline bool process_running(unsigned long pid) {
+    std::ostringstream path;
+    path << "/proc/" << pid << "/stat";
+    std::string contents;
+    if (!read_whole_file(path.str().c_str(), contents)) {
+        return false;
+    }
+    // The state follows the command name, which is in parentheses
+    std::string::size_type state = contents.rfind(')');
+    if (state == std::string::npos || state + 2 >= contents.size()) {
+        return false;
+    }
+    return contents[state + 2] != 'Z' && contents[state + 2] != 'X';
+}
+}
+
+/** \brief Find running processes by name or command line
+ *
+ * With PROCESS_COMM, a process matches if its executable name equals
+ * 'pattern', or starts with the text before a trailing '*' (as with
+ * RegionFilter::name). With PROCESS_CMDLINE, a process matches if its
+ * command line contains 'pattern'. The IDs of matching processes are
+ * appended to 'pids' in increasing order.
+ *
+ * \returns The number of matching processes
+ */
+inline std::size_t find_processes(const std::string& pattern,
+                                  std::vector<unsigned long>& pids,
+                                  ProcessField field = PROCESS_COMM) {
+    DIR* proc = opendir("/proc");
+    if (!proc) {
+        return 0;
+    }
+    const std::size_t first = pids.size();
+    while (dirent* entry = readdir(proc)) {
+        char* end;
+        unsigned long pid = std::strtoul(entry->d_name, &end, 10);
+        if (*end != '\0' || end == entry->d_name) {
+            continue;
+        }
+        if (detail::process_matches(pid, pattern, field)) {
+            pids.push_back(pid);
+        }
+    }
+    closedir(proc);
+    std::sort(pids.begin() + first, pids.end());
+    return pids.size() - first;
+}
+
+/** \brief Scans several processes at once with a shared pool of threads
+ *
+ * Each process is read through its own LinuxMemoryContext, but the chunks
+ * of every process's regions are scanned by a single ThreadPool, so a few
+ * threads can keep busy across many small processes (the workers of a
+ * prefork server, for example). Matches are passed to the callback along
+ * with the ID of the process they were found in.
+ *
+ * \code{.c}
+ * struct PrintPosition {
+ *   void operator()(unsigned long pid, address_t address,
+ *                   const Position& p) {
+ *     ...
+ *   }
+ * };
+ *
+ * MultiProcessScanner scanner(RegionFilter::writable_data());
+ * scanner.add_matching("httpd");
+ * scanner.scan<PositionMatcher>(8, PrintPosition());
+ * \endcode
+ *
+ * A process that exits before or during a scan does not stop the scan of
+ * the others. Matches found in it before it exited are still delivered,
+ * and its ID is listed by `exited` afterwards.
+ */
+class MultiProcessScanner {
+public:
+    explicit MultiProcessScanner(const RegionFilter& filter = RegionFilter())
+        : m_filter(filter), m_matches(0) {}
+
+    ~MultiProcessScanner() {
+        for (std::size_t i = 0; i < m_contexts.size(); ++i) {
+            delete m_contexts[i];
+        }
+    }
+
+    /// Add a process to the scan
+    void add(unsigned long pid) {
+        for (std::size_t i = 0; i < m_contexts.size(); ++i) {
+            if (m_contexts[i]->pid() == pid) {
+                return;
+            }
+        }
+        m_contexts.push_back(new LinuxMemoryContext(pid, m_filter));
+    }
+
+    /// Add every process found by find_processes
+    /**
+     * \returns The number of matching processes
+     */
+    std::size_t add_matching(const std::string& pattern,
+                             ProcessField field = PROCESS_COMM) {
+        std::vector<unsigned long> pids;
+        find_processes(pattern, pids, field);
+        for (std::size_t i = 0; i < pids.size(); ++i) {
+            add(pids[i]);
+        }
+        return pids.size();
+    }
+
+    /// Remove the processes that exited during the last scan
+    void remove_exited() {
+        for (std::size_t i = 0; i < m_contexts.size();) {
+            if (std::find(m_exited.begin(), m_exited.end(),
+                          m_contexts[i]->pid()) != m_exited.end()) {
+                delete m_contexts[i];
+                m_contexts.erase(m_contexts.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+        m_exited.clear();
+    }
+
+    /// The number of processes being scanned
+    std::size_t size() const { return m_contexts.size(); }
+
+    /// The context used to read one of the processes
+    LinuxMemoryContext& context(std::size_t index) {
+        return *m_contexts[index];
+    }
+
+    /// The processes that had exited by the end of the last scan
+    const std::vector<unsigned long>& exited() const { return m_exited; }
+
+    /// Scan every process for MemObjects
+    /**
+     * The regions of every process are updated, split into chunks of
+     * 'chunk_size' bytes and scanned by a pool of 'threads' workers.
+     * `callback(pid, address, object)` is invoked for each match. Calls to
+     * the callback are serialized, but may come from any worker thread,
+     * and matches are delivered as soon as their chunk has been scanned.
+     *
+     * If 'stats' is given, it receives the combined statistics of every
+     * process.
+     *
+     * \returns The number of matches found
+     */
+    template <typename MemObject, typename Callback>
+    std::size_t
+    scan(unsigned threads, Callback callback,
+         std::size_t chunk_size = default_parallel_chunk_size,
+         ScanStats* stats = NULL) {
+        typedef typename MemObject::type type;
+        const std::size_t alignment = detail::ScanKernel<MemObject>::alignment;
+        chunk_size -= chunk_size % alignment;
+        if (chunk_size < alignment) {
+            chunk_size = alignment;
+        }
+
+        m_exited.clear();
+        std::vector<Chunk<MemObject, Callback> > chunks;
+        for (std::size_t p = 0; p < m_contexts.size(); ++p) {
+            LinuxMemoryContext& ctx = *m_contexts[p];
+            ctx.update_regions();
+            if (ctx.mapped_regions().empty()) {
+                if (!detail::process_running(ctx.pid())) {
+                    m_exited.push_back(ctx.pid());
+                }
+                continue;
+            }
+
+            const std::vector<LinuxMemoryContext::MemoryRegion>& regions =
+                ctx.mapped_regions();
+            for (std::size_t i = 0; i < regions.size(); ++i) {
+                const address_t end = regions[i].end_address;
+                for (address_t start = regions[i].start_address; start < end;
+                     start += chunk_size) {
+                    Chunk<MemObject, Callback> chunk;
+                    chunk.scan = this;
+                    chunk.ctx = &ctx;
+                    chunk.callback = &callback;
+                    chunk.failed = false;
+                    chunk.start = start;
+                    chunk.scan_end = start + chunk_size;
+                    if (chunk.scan_end > end || chunk.scan_end < start) {
+                        chunk.scan_end = end;
+                    }
+                    chunk.read_end = chunk.scan_end + sizeof(type) - 1;
+                    if (chunk.read_end > end ||
+                        chunk.read_end < chunk.scan_end) {
+                        chunk.read_end = end;
+                    }
+                    chunks.push_back(chunk);
+                }
+            }
+        }
+
+        double started = 0;
+        FREUD_STAT(started = detail::stats_clock());
+        m_matches = 0;
+        {
+            detail::ThreadPool pool(threads);
+            m_workers.resize(pool.size());
+            for (std::size_t i = 0; i < chunks.size(); ++i) {
+                pool.submit(&chunks[i]);
+            }
+            pool.wait();
+        }
+
+        // A process whose reads failed may have exited during the scan
+        ScanStats result;
+        for (std::size_t i = 0; i < chunks.size(); ++i) {
+            result.add(chunks[i].counters);
+            const unsigned long pid = chunks[i].ctx->pid();
+            if (chunks[i].failed && (m_exited.empty() ||
+                                     m_exited.back() != pid) &&
+                !detail::process_running(pid)) {
+                m_exited.push_back(pid);
+            }
+        }
+        if (stats) {
+            *stats = result;
+            FREUD_STAT(stats->wall_seconds = detail::stats_clock() - started);
+        }
+        return m_matches;
+    }
+
+private:
+    MultiProcessScanner(const MultiProcessScanner&);
+    MultiProcessScanner& operator=(const MultiProcessScanner&);
+
+    template <typename MemObject, typename Callback>
+    struct Chunk : public detail::Task {
+        typedef typename MemObject::type type;
+
+        MultiProcessScanner* scan;
+        LinuxMemoryContext* ctx;
+        Callback* callback;
+        address_t start;
+        address_t scan_end;
+        address_t read_end;
+        ScanCounters counters;
+
+        // Whether any of the chunk's bytes could not be read
+        bool failed;
+
+        // Matches found in this chunk
+        std::vector<address_t> addresses;
+        std::vector<byte_t> objects;
+
+        void run(unsigned worker) { scan->scan_chunk(*this, worker); }
+    };
+
+    template <typename MemObject, typename Callback>
+    struct ChunkSink {
+        typedef typename MemObject::type type;
+
+        Chunk<MemObject, Callback>* chunk;
+
+        bool operator()(address_t address, const type& object) {
+            const byte_t* bytes = reinterpret_cast<const byte_t*>(&object);
+            chunk->addresses.push_back(address);
+            chunk->objects.insert(chunk->objects.end(), bytes,
+                                  bytes + sizeof(type));
+            return true;
+        }
+    };
+
+    template <typename MemObject, typename Callback>
+    void scan_chunk(Chunk<MemObject, Callback>& chunk, unsigned worker) {
+        typedef typename MemObject::type type;
+
+        double started = 0;
+        FREUD_STAT(started = detail::stats_clock());
+        ChunkSink<MemObject, Callback> sink = {&chunk};
+        detail::read_and_scan<MemObject>(*chunk.ctx, chunk.start,
+                                         chunk.scan_end, chunk.read_end,
+                                         m_workers[worker], sink,
+                                         &chunk.counters);
+        chunk.failed = !m_workers[worker].failed.empty();
+        FREUD_STAT(chunk.counters.matches = chunk.addresses.size());
+        FREUD_STAT(chunk.counters.seconds = detail::stats_clock() - started);
+
+        detail::ScopedLock lock(m_delivery_mutex);
+        const unsigned long pid = chunk.ctx->pid();
+        for (std::size_t i = 0; i < chunk.addresses.size(); ++i) {
+            (*chunk.callback)(pid, chunk.addresses[i],
+                              *reinterpret_cast<const type*>(
+                                  &chunk.objects[i * sizeof(type)]));
+        }
+        m_matches += chunk.addresses.size();
+        std::vector<address_t>().swap(chunk.addresses);
+        std::vector<byte_t>().swap(chunk.objects);
+    }
+
+    RegionFilter m_filter;
+    std::vector<LinuxMemoryContext*> m_contexts;
+    std::vector<unsigned long> m_exited;
+
+    std::vector<detail::ScanScratch> m_workers;
+    detail::Mutex m_delivery_mutex;
+    std::size_t m_matches;
+};
+}
+
+#endif
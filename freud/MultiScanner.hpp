@@ -0,0 +1,224 @@
+#ifndef FREUD_MULTI_SCANNER
+#define FREUD_MULTI_SCANNER
+
+#include "freud/MemoryContext.hpp"
+#include "freud/RangeScan.hpp"
+#include <vector>
+
+namespace freud {
+
+/// The default number of bytes of a region that are read at once by a
+/// MultiScanner
+const std::size_t default_multi_scan_chunk_size = 256 * 1024;
+
+namespace detail {
+
+/// A type-erased MemObject registered with a MultiScanner
+template <typename Context>
+class MatcherBase {
+public:
+    virtual ~MatcherBase() {}
+
+    /// Check the objects starting in the first 'scan_length' of the
+    /// 'length' bytes at 'data' (see scan_readable)
+    virtual void scan(const Context& ctx, const byte_t* data,
+                      address_t start, std::size_t length,
+                      std::size_t scan_length,
+                      const std::vector<FailedRange>& failed,
+                      ScanCounters* counters) = 0;
+
+    /// The number of matches found so far
+    std::size_t matches() const { return m_matches; }
+
+    void reset() { m_matches = 0; }
+
+protected:
+    MatcherBase() : m_matches(0) {}
+
+    std::size_t m_matches;
+};
+
+template <typename MemObject, typename Context, typename Callback>
+class Matcher : public MatcherBase<Context> {
+public:
+    typedef typename MemObject::type type;
+
+    explicit Matcher(Callback callback) : m_callback(callback) {}
+
+    void scan(const Context& ctx, const byte_t* data, address_t start,
+              std::size_t length, std::size_t scan_length,
+              const std::vector<FailedRange>& failed,
+              ScanCounters* counters) {
+        Sink sink = {this};
+        scan_readable<MemObject>(ctx, data, start, length, scan_length,
+                                 failed, sink, counters);
+    }
+
+private:
+    struct Sink {
+        Matcher* matcher;
+
+        bool operator()(address_t address, const type& object) {
+            matcher->m_callback(address, object);
+            ++matcher->m_matches;
+            return true;
+        }
+    };
+
+    Callback m_callback;
+};
+}
+
+/** \brief Scans a context for several MemObjects in a single pass
+ *
+ * Scanning for each of several types with its own `scan_once` reads the
+ * target once per type. A MultiScanner instead reads each chunk of a
+ * region once, and runs the checks of every registered MemObject over it
+ * while the bytes are still in the CPU's cache. The amount of memory read
+ * does not depend on the number of MemObjects.
+ *
+ * Each MemObject is registered with its own callback, which receives its
+ * matches as `callback(address, object)` with the object's own type:
+ *
+ * \code{.c}
+ * MultiScanner<> scanner;
+ * scanner.add<PositionMatcher>(PrintPosition());
+ * scanner.add<PlayerMatcher>(PrintPlayer());
+ * scanner.scan(ctx);
+ * \endcode
+ *
+ * Within each chunk, the MemObjects are checked in the order they were
+ * added, so the matches of one MemObject are delivered in address order,
+ * but may be interleaved with those of the others.
+ */
+template <typename Context = MemoryContext>
+class MultiScanner {
+public:
+    explicit MultiScanner(
+        std::size_t chunk_size = default_multi_scan_chunk_size)
+        : m_chunk_size(chunk_size), m_max_object_size(0) {}
+
+    ~MultiScanner() {
+        for (std::size_t i = 0; i < m_matchers.size(); ++i) {
+            delete m_matchers[i];
+        }
+    }
+
+    /// Register a MemObject, whose matches are passed to 'callback'
+    /**
+     * \returns The index of the MemObject, for use with `matches`
+     */
+    template <typename MemObject, typename Callback>
+    std::size_t add(Callback callback) {
+        m_matchers.push_back(
+            new detail::Matcher<MemObject, Context, Callback>(callback));
+        if (sizeof(typename MemObject::type) > m_max_object_size) {
+            m_max_object_size = sizeof(typename MemObject::type);
+        }
+        return m_matchers.size() - 1;
+    }
+
+    /// The number of registered MemObjects
+    std::size_t size() const { return m_matchers.size(); }
+
+    /// The number of matches of the MemObject with the given index in the
+    /// last scan
+    std::size_t matches(std::size_t index) const {
+        return m_matchers[index]->matches();
+    }
+
+    /// Scan every region of the context once
+    /**
+     * If 'stats' is given, it receives the statistics of the scan, with
+     * the verify calls and matches of every MemObject combined.
+     *
+     * \returns The total number of matches
+     */
+    std::size_t scan(Context& ctx, ScanStats* stats = NULL) {
+        typedef typename Context::MemoryRegion MemoryRegion;
+
+        for (std::size_t i = 0; i < m_matchers.size(); ++i) {
+            m_matchers[i]->reset();
+        }
+        if (m_matchers.empty()) {
+            return 0;
+        }
+
+        ScanStats result;
+        double started = 0;
+        FREUD_STAT(started = detail::stats_clock());
+        const std::vector<MemoryRegion>& regions = ctx.mapped_regions();
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            RegionStats region;
+            region.start_address = regions[i].start_address;
+            region.end_address = regions[i].end_address;
+            const std::size_t before = total_matches();
+            FREUD_STAT(region.seconds = detail::stats_clock());
+            scan_region(ctx, region.start_address, region.end_address,
+                        &region);
+            FREUD_STAT(region.seconds = detail::stats_clock() -
+                                        region.seconds);
+            FREUD_STAT(region.matches = total_matches() - before);
+            region.skipped = region.failed_reads > 0;
+
+            result.add(region);
+            result.regions_skipped += region.skipped ? 1 : 0;
+            if (ctx.region_stats()) {
+                result.regions.push_back(region);
+            }
+        }
+        FREUD_STAT(result.wall_seconds = detail::stats_clock() - started);
+        if (stats) {
+            *stats = result;
+        }
+        return total_matches();
+    }
+
+private:
+    MultiScanner(const MultiScanner&);
+    MultiScanner& operator=(const MultiScanner&);
+
+    std::size_t total_matches() const {
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < m_matchers.size(); ++i) {
+            total += m_matchers[i]->matches();
+        }
+        return total;
+    }
+
+    void scan_region(Context& ctx, address_t start, address_t end,
+                     ScanCounters* counters) {
+        // Chunks start at multiples of 64 bytes from the start of the
+        // region, which suits the alignment of any MemObject
+        const std::size_t chunk_size =
+            m_chunk_size < 64 ? 64 : m_chunk_size - m_chunk_size % 64;
+
+        for (address_t chunk = start; chunk < end; chunk += chunk_size) {
+            address_t scan_end = chunk + chunk_size;
+            if (scan_end > end || scan_end < chunk) {
+                scan_end = end;
+            }
+            address_t read_end = scan_end + m_max_object_size - 1;
+            if (read_end > end || read_end < scan_end) {
+                read_end = end;
+            }
+
+            const std::size_t length = read_end - chunk;
+            const byte_t* data =
+                detail::read_range(ctx, chunk, length, m_scratch, counters);
+            for (std::size_t m = 0; m < m_matchers.size(); ++m) {
+                m_matchers[m]->scan(ctx, data, chunk, length,
+                                    scan_end - chunk, m_scratch.failed,
+                                    counters);
+            }
+        }
+    }
+
+    std::vector<detail::MatcherBase<Context>*> m_matchers;
+    std::size_t m_chunk_size;
+    std::size_t m_max_object_size;
+    detail::ScanScratch m_scratch;
+};
+}
+
+#endif
@@ -0,0 +1,515 @@
+#ifndef FREUD_NEEDLE_SCANNER
+#define FREUD_NEEDLE_SCANNER
+
+#include "freud/AlignedBuffer.hpp"
+#include "freud/MemoryContext.hpp"
+#include "freud/Prefilter.hpp"
+#include "freud/RangeScan.hpp"
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+namespace freud {
+
+/// The default number of bytes of a region that a NeedleScanner reads at
+/// once
+const std::size_t default_needle_chunk_size = 4 * 1024 * 1024;
+
+namespace detail {
+
+/// Only defined for the needle widths a NeedleScanner supports
+template <std::size_t Width>
+struct SupportedNeedleWidth;
+
+template <>
+struct SupportedNeedleWidth<4> {};
+template <>
+struct SupportedNeedleWidth<8> {};
+template <>
+struct SupportedNeedleWidth<16> {};
+template <>
+struct SupportedNeedleWidth<32> {};
+
+/// Hash the 'Width' bytes at 'bytes'
+template <std::size_t Width>
+inline uint64_t hash_needle(const byte_t* bytes) {
+    static const std::size_t word_size = Width < 8 ? Width : 8;
+    uint64_t hash = Width;
+    for (std::size_t i = 0; i < Width; i += word_size) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes + i, word_size);
+        hash = (hash ^ word) * 0xBF58476D1CE4E5B9ULL;
+        hash ^= hash >> 31;
+    }
+    hash *= 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 29);
+}
+
+/** \brief A split block Bloom filter
+ *
+ * Each key sets one bit in each of the eight 32 bit words of a single 32
+ * byte block, so testing a key touches one cache line (the blocks are
+ * aligned) and the eight bits can be checked with a few SIMD instructions.
+ * The upper half of a key's hash selects the block and the lower half the
+ * bits. With 16 bits per key, about one in 1000 of the keys that were not
+ * inserted pass the filter.
+ */
+class NeedleFilter {
+public:
+    static const std::size_t bits_per_key = 16;
+    static const std::size_t block_words = 8;
+    static const std::size_t block_size = block_words * sizeof(uint32_t);
+
+    NeedleFilter() : m_blocks(0) {}
+
+    /// Empty the filter and size it for 'keys' keys
+    void reset(std::size_t keys) {
+        m_blocks = (keys * bits_per_key + 255) / 256;
+        if (m_blocks == 0) {
+            m_blocks = 1;
+        }
+        m_words.resize(m_blocks * block_size);
+        std::memset(m_words.data(), 0, m_words.size());
+    }
+
+    void insert(uint64_t hash) {
+        uint32_t* block = reinterpret_cast<uint32_t*>(
+            m_words.data() + block_index(hash) * block_size);
+        for (std::size_t i = 0; i < block_words; ++i) {
+            block[i] |= bit(uint32_t(hash), i);
+        }
+    }
+
+    /// The first word of the block that 'hash' maps to
+    const uint32_t* block(uint64_t hash) const {
+        return reinterpret_cast<const uint32_t*>(
+            m_words.data() + block_index(hash) * block_size);
+    }
+
+    /// Test the bits of 'hash' in its block
+    static bool test(const uint32_t* block, uint32_t hash) {
+        for (std::size_t i = 0; i < block_words; ++i) {
+            if (!(block[i] & bit(hash, i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static uint32_t salt(std::size_t i) {
+        static const uint32_t salts[block_words] = {
+            0x47B6137BU, 0x44974D91U, 0x8824AD5BU, 0xA2B7289DU,
+            0x705495C7U, 0x2DF1424BU, 0x9EFC4947U, 0x5C6BFB31U};
+        return salts[i];
+    }
+
+    /// The number of bytes used by the filter
+    std::size_t size_in_bytes() const { return m_words.size(); }
+
+private:
+    std::size_t block_index(uint64_t hash) const {
+        // Maps the upper half of the hash onto [0, m_blocks) without a
+        // division
+        return std::size_t(((hash >> 32) * uint64_t(m_blocks)) >> 32);
+    }
+
+    static uint32_t bit(uint32_t hash, std::size_t i) {
+        return uint32_t(1) << ((hash * salt(i)) >> 27);
+    }
+
+    AlignedBuffer m_words;
+    std::size_t m_blocks;
+};
+
+/// Sweep the offsets [pos, end) of 'data' in steps of 'stride', storing
+/// those whose bytes pass 'filter' in 'out' (which has room for 'capacity'
+/// offsets)
+/**
+ * \returns The offset to continue the sweep from, which is 'end' (or past
+ *          it) unless 'out' filled up
+ */
+typedef std::size_t (*NeedleSweepFunction)(const byte_t* data,
+                                           std::size_t pos, std::size_t end,
+                                           std::size_t stride,
+                                           const NeedleFilter& filter,
+                                           std::size_t* out,
+                                           std::size_t capacity,
+                                           std::size_t& count);
+
+/// The number of offsets a sweep hashes before testing any of them, so
+/// the loads of their filter blocks overlap
+const std::size_t needle_sweep_group = 8;
+
+template <std::size_t Width>
+std::size_t sweep_needles_scalar(const byte_t* data, std::size_t pos,
+                                 std::size_t end, std::size_t stride,
+                                 const NeedleFilter& filter, std::size_t* out,
+                                 std::size_t capacity, std::size_t& count) {
+    const std::size_t group = needle_sweep_group;
+    while (pos + (group - 1) * stride < end &&
+           count + group <= capacity) {
+        const uint32_t* blocks[group];
+        uint32_t keys[group];
+        for (std::size_t j = 0; j < group; ++j) {
+            const uint64_t hash = hash_needle<Width>(data + pos + j * stride);
+            blocks[j] = filter.block(hash);
+            keys[j] = uint32_t(hash);
+            __builtin_prefetch(blocks[j]);
+        }
+        for (std::size_t j = 0; j < group; ++j) {
+            if (NeedleFilter::test(blocks[j], keys[j])) {
+                out[count++] = pos + j * stride;
+            }
+        }
+        pos += group * stride;
+    }
+    for (; pos < end && count < capacity; pos += stride) {
+        const uint64_t hash = hash_needle<Width>(data + pos);
+        if (NeedleFilter::test(filter.block(hash), uint32_t(hash))) {
+            out[count++] = pos;
+        }
+    }
+    return pos;
+}
+
+#ifdef FREUD_X86_SIMD
+/// Test the eight bits of 'hash' in a filter block at once
+__attribute__((target("avx2"))) inline bool
+test_needle_block_avx2(const uint32_t* block, uint32_t hash) {
+    const __m256i salts = _mm256_setr_epi32(
+        NeedleFilter::salt(0), NeedleFilter::salt(1), NeedleFilter::salt(2),
+        NeedleFilter::salt(3), NeedleFilter::salt(4), NeedleFilter::salt(5),
+        NeedleFilter::salt(6), NeedleFilter::salt(7));
+    const __m256i shifts = _mm256_srli_epi32(
+        _mm256_mullo_epi32(_mm256_set1_epi32(hash), salts), 27);
+    const __m256i bits = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+    const __m256i words =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    return _mm256_testc_si256(words, bits);
+}
+
+template <std::size_t Width>
+__attribute__((target("avx2"))) std::size_t
+sweep_needles_avx2(const byte_t* data, std::size_t pos, std::size_t end,
+                   std::size_t stride, const NeedleFilter& filter,
+                   std::size_t* out, std::size_t capacity,
+                   std::size_t& count) {
+    const std::size_t group = needle_sweep_group;
+    while (pos + (group - 1) * stride < end &&
+           count + group <= capacity) {
+        const uint32_t* blocks[group];
+        uint32_t keys[group];
+        for (std::size_t j = 0; j < group; ++j) {
+            const uint64_t hash = hash_needle<Width>(data + pos + j * stride);
+            blocks[j] = filter.block(hash);
+            keys[j] = uint32_t(hash);
+            __builtin_prefetch(blocks[j]);
+        }
+        for (std::size_t j = 0; j < group; ++j) {
+            if (test_needle_block_avx2(blocks[j], keys[j])) {
+                out[count++] = pos + j * stride;
+            }
+        }
+        pos += group * stride;
+    }
+    for (; pos < end && count < capacity; pos += stride) {
+        const uint64_t hash = hash_needle<Width>(data + pos);
+        if (test_needle_block_avx2(filter.block(hash), uint32_t(hash))) {
+            out[count++] = pos;
+        }
+    }
+    return pos;
+}
+#endif
+
+/// Choose the fastest sweep supported by this CPU
+template <std::size_t Width>
+NeedleSweepFunction select_needle_sweep() {
+#ifdef FREUD_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &sweep_needles_avx2<Width>;
+    }
+#endif
+    return &sweep_needles_scalar<Width>;
+}
+}
+
+/** \brief Finds every occurrence of any of a large set of values
+ *
+ * A NeedleScanner searches a context for many fixed width values (of 4, 8,
+ * 16 or 32 bytes) at once, such as a list of known pointers, session IDs
+ * or hashes, and reports each `(needle, address)` hit:
+ *
+ * \code{.c}
+ * struct PrintHit {
+ *     void operator()(address_t address, std::size_t needle) {
+ *         std::cout << std::hex << address << ": " << needle << "\n";
+ *     }
+ * };
+ *
+ * NeedleScanner<8> scanner(ctx);
+ * for (std::size_t i = 0; i < pointers.size(); ++i) {
+ *     scanner.add(&pointers[i]);
+ * }
+ * scanner.scan(PrintHit());
+ * \endcode
+ *
+ * Every aligned offset of each region is hashed and tested against a
+ * split block Bloom filter (see detail::NeedleFilter), with the filter
+ * blocks for several offsets loaded at once and tested with AVX2
+ * instructions where available. Only the offsets that pass the filter are
+ * looked up in an exact hash set of the needles, so the cost of a scan
+ * barely depends on the number of needles, and millions of them take at
+ * most (Width + 18) bytes each.
+ *
+ * Every region of the context is scanned, so a context created with a
+ * RegionFilter limits where the needles are looked for.
+ */
+template <std::size_t Width, typename Context = MemoryContext>
+class NeedleScanner {
+    typedef char width_is_supported
+        [sizeof(detail::SupportedNeedleWidth<Width>) > 0 ? 1 : -1];
+
+public:
+    static const std::size_t width = Width;
+
+    /// Returned by `find` for a value that is not a needle
+    static const std::size_t npos = std::size_t(-1);
+
+    explicit NeedleScanner(
+        Context& ctx, std::size_t chunk_size = default_needle_chunk_size)
+        : m_ctx(ctx), m_chunk_size(chunk_size < 64 ? 64 : chunk_size & ~63),
+          m_alignment(Width < 8 ? Width : 8), m_built(false), m_mask(0),
+          m_bytes_scanned(0), m_filter_passes(0) {}
+
+    /// Add the 'Width' bytes at 'value' as a needle
+    /**
+     * \returns The index of the needle, which is how hits on it are
+     *          reported
+     */
+    std::size_t add(const void* value) {
+        const byte_t* bytes = static_cast<const byte_t*>(value);
+        m_needles.insert(m_needles.end(), bytes, bytes + Width);
+        m_built = false;
+        return size() - 1;
+    }
+
+    /// Reserve memory for 'needles' needles
+    void reserve(std::size_t needles) { m_needles.reserve(needles * Width); }
+
+    /// The number of needles that have been added
+    std::size_t size() const { return m_needles.size() / Width; }
+
+    /// The bytes of the needle with index 'needle'
+    const byte_t* needle(std::size_t needle) const {
+        return &m_needles[needle * Width];
+    }
+
+    /// Remove every needle
+    void clear() {
+        m_needles.clear();
+        m_built = false;
+    }
+
+    /// Only test offsets that are a multiple of 'alignment' from the start
+    /// of a region
+    /**
+     * By default this is the needle width, or 8 for needles wider than 8
+     * bytes. The alignment is at most the needle width.
+     */
+    void set_alignment(std::size_t alignment) {
+        m_alignment =
+            alignment == 0 ? 1 : (alignment > Width ? Width : alignment);
+    }
+
+    std::size_t alignment() const { return m_alignment; }
+
+    /// The index of the needle equal to the 'Width' bytes at 'value', or
+    /// npos
+    /**
+     * If several needles are equal, this is the first of them.
+     */
+    std::size_t find(const void* value) {
+        build();
+        const byte_t* bytes = static_cast<const byte_t*>(value);
+        return lookup(bytes, detail::hash_needle<Width>(bytes));
+    }
+
+    /// Find the needles in every region
+    /**
+     * The context's mapped regions are updated first.
+     * `callback(address, needle)` is invoked for every occurrence of a
+     * needle in address order, where 'needle' is its index (the first one,
+     * if several needles are equal).
+     *
+     * \returns The number of hits
+     */
+    template <typename Callback>
+    std::size_t scan(Callback callback) {
+        typedef typename Context::MemoryRegion MemoryRegion;
+        static const detail::NeedleSweepFunction sweep =
+            detail::select_needle_sweep<Width>();
+
+        build();
+        m_ctx.update_regions();
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+        m_bytes_scanned = 0;
+        m_filter_passes = 0;
+        if (size() == 0) {
+            return 0;
+        }
+
+        std::size_t candidates[256];
+        const std::size_t capacity = sizeof(candidates) / sizeof(*candidates);
+        std::size_t hits = 0;
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            const address_t end = regions[i].end_address;
+            for (address_t chunk = regions[i].start_address; chunk < end;
+                 chunk += m_chunk_size) {
+                address_t scan_end = chunk + m_chunk_size;
+                if (scan_end > end || scan_end < chunk) {
+                    scan_end = end;
+                }
+                address_t read_end = scan_end + Width - 1;
+                if (read_end > end || read_end < scan_end) {
+                    read_end = end;
+                }
+                const std::size_t length = read_end - chunk;
+                if (length < Width) {
+                    continue;
+                }
+                const byte_t* data =
+                    detail::read_range(m_ctx, chunk, length, m_scratch);
+                m_bytes_scanned += length;
+
+                // Offsets past 'last' would read beyond the bytes
+                std::size_t last = scan_end - chunk;
+                if (last > length - Width + 1) {
+                    last = length - Width + 1;
+                }
+                // The first offset of the chunk that is a multiple of the
+                // alignment from the start of the region
+                const std::size_t phase =
+                    (chunk - regions[i].start_address) % m_alignment;
+                std::size_t failed = 0;
+                for (std::size_t pos = phase == 0 ? 0 : m_alignment - phase;
+                     pos < last;) {
+                    std::size_t count = 0;
+                    pos = sweep(data, pos, last, m_alignment, m_filter,
+                                candidates, capacity, count);
+                    m_filter_passes += count;
+                    for (std::size_t c = 0; c < count; ++c) {
+                        const byte_t* bytes = data + candidates[c];
+                        const std::size_t needle =
+                            lookup(bytes, detail::hash_needle<Width>(bytes));
+                        const address_t address = chunk + candidates[c];
+                        if (needle != npos &&
+                            !unreadable(address, failed)) {
+                            callback(address, needle);
+                            ++hits;
+                        }
+                    }
+                }
+            }
+        }
+        return hits;
+    }
+
+    /// The number of bytes that were read by the last scan
+    std::size_t bytes_scanned() const { return m_bytes_scanned; }
+
+    /// The number of offsets that passed the filter in the last scan, and
+    /// were looked up in the exact set
+    std::size_t filter_passes() const { return m_filter_passes; }
+
+    /// The number of bytes used by the filter and the exact set
+    std::size_t index_size_in_bytes() {
+        build();
+        return m_filter.size_in_bytes() + m_slots.size() * sizeof(uint32_t);
+    }
+
+private:
+    NeedleScanner(const NeedleScanner&);
+    NeedleScanner& operator=(const NeedleScanner&);
+
+    /// Build the filter and the exact set, if needles were added since
+    /// they were last built
+    void build() {
+        if (m_built) {
+            return;
+        }
+        const std::size_t needles = size();
+        m_filter.reset(needles);
+
+        // An open addressing table of needle indices plus one (zero marks
+        // an empty slot), at most half full
+        std::size_t slots = 16;
+        while (slots < needles * 2) {
+            slots *= 2;
+        }
+        m_slots.assign(slots, 0);
+        m_mask = slots - 1;
+        for (std::size_t i = 0; i < needles; ++i) {
+            const byte_t* bytes = needle(i);
+            const uint64_t hash = detail::hash_needle<Width>(bytes);
+            std::size_t slot = std::size_t(hash) & m_mask;
+            for (; m_slots[slot] != 0; slot = (slot + 1) & m_mask) {
+                if (std::memcmp(needle(m_slots[slot] - 1), bytes, Width) ==
+                    0) {
+                    break;
+                }
+            }
+            if (m_slots[slot] == 0) {
+                m_slots[slot] = uint32_t(i + 1);
+                m_filter.insert(hash);
+            }
+        }
+        m_built = true;
+    }
+
+    /// The index of the needle equal to 'bytes' (whose hash is 'hash'),
+    /// or npos
+    std::size_t lookup(const byte_t* bytes, uint64_t hash) const {
+        for (std::size_t slot = std::size_t(hash) & m_mask;
+             m_slots[slot] != 0; slot = (slot + 1) & m_mask) {
+            const std::size_t index = m_slots[slot] - 1;
+            if (std::memcmp(needle(index), bytes, Width) == 0) {
+                return index;
+            }
+        }
+        return npos;
+    }
+
+    /// True if the needle at 'address' overlaps a page that could not be
+    /// read, whose bytes are zero rather than the target's. 'next' is the
+    /// first failed range that may still overlap, as hits are found in
+    /// address order.
+    bool unreadable(address_t address, std::size_t& next) const {
+        const std::vector<FailedRange>& failed = m_scratch.failed;
+        while (next < failed.size() && failed[next].end_address <= address) {
+            ++next;
+        }
+        return next < failed.size() &&
+               failed[next].start_address < address + Width;
+    }
+
+    Context& m_ctx;
+    std::size_t m_chunk_size;
+    std::size_t m_alignment;
+
+    // The bytes of each needle, in the order they were added
+    std::vector<byte_t> m_needles;
+
+    bool m_built;
+    detail::NeedleFilter m_filter;
+    std::vector<uint32_t> m_slots;
+    std::size_t m_mask;
+
+    detail::ScanScratch m_scratch;
+    std::size_t m_bytes_scanned;
+    std::size_t m_filter_passes;
+};
+}
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef FREUD_PAGE_CACHE
+#define FREUD_PAGE_CACHE
+
+#include "freud/AlignedBuffer.hpp"
+#include "freud/Defines.hpp"
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace freud {
+
+/// The default number of pages held by a context's page cache
+const std::size_t default_page_cache_pages = 256;
+
+namespace detail {
+
+/** \brief A least-recently-used cache of fixed size pages
+ *
+ * The cache holds copies of up to 'capacity' pages of target memory, each
+ * 'page_size' bytes long and identified by its starting address. When the
+ * cache is full, inserting a page evicts the page that was used least
+ * recently. It is meant for the small, scattered reads made by verifiers
+ * following pointers, and is separate from a context's sequential scan
+ * window, so the two do not evict each other.
+ *
+ * A PageCache is not thread safe.
+ */
+class PageCache {
+public:
+    PageCache(std::size_t capacity, std::size_t page_size)
+        : m_page_size(page_size), m_head(none), m_tail(none) {
+        set_capacity(capacity);
+    }
+
+    std::size_t page_size() const { return m_page_size; }
+
+    /// The maximum number of pages held
+    std::size_t capacity() const { return m_entries.size(); }
+
+    /// Change the maximum number of pages held. This empties the cache.
+    void set_capacity(std::size_t capacity) {
+        m_entries.assign(capacity, Entry());
+        m_pages.resize(capacity * m_page_size);
+        clear();
+    }
+
+    /// Remove every page
+    void clear() {
+        m_index.clear();
+        m_free.clear();
+        for (std::size_t i = m_entries.size(); i > 0; --i) {
+            m_free.push_back(i - 1);
+        }
+        m_head = none;
+        m_tail = none;
+    }
+
+    /// Get the cached bytes of a page (which becomes the most recently
+    /// used), or NULL if the page is not cached
+    const byte_t* find(address_t page) {
+        std::map<address_t, std::size_t>::const_iterator iter =
+            m_index.find(page);
+        if (iter == m_index.end()) {
+            return NULL;
+        }
+        unlink(iter->second);
+        push_front(iter->second);
+        return slot(iter->second);
+    }
+
+    /// Store a copy of the 'page_size' bytes of a page
+    void insert(address_t page, const byte_t* data) {
+        if (m_entries.empty()) {
+            return;
+        }
+        std::size_t entry;
+        std::map<address_t, std::size_t>::const_iterator iter =
+            m_index.find(page);
+        if (iter != m_index.end()) {
+            entry = iter->second;
+            unlink(entry);
+        } else if (!m_free.empty()) {
+            entry = m_free.back();
+            m_free.pop_back();
+        } else {
+            // Evict the least recently used page
+            entry = m_tail;
+            unlink(entry);
+            m_index.erase(m_entries[entry].page);
+        }
+        m_entries[entry].page = page;
+        m_index[page] = entry;
+        push_front(entry);
+        std::memcpy(slot(entry), data, m_page_size);
+    }
+
+private:
+    static const std::size_t none = ~std::size_t(0);
+
+    struct Entry {
+        address_t page;
+
+        // The neighbouring entries in the list of pages, from most to least
+        // recently used
+        std::size_t previous;
+        std::size_t next;
+
+        Entry() : page(0), previous(none), next(none) {}
+    };
+
+    byte_t* slot(std::size_t entry) {
+        return m_pages.data() + entry * m_page_size;
+    }
+
+    void unlink(std::size_t entry) {
+        Entry& e = m_entries[entry];
+        if (e.previous != none) {
+            m_entries[e.previous].next = e.next;
+        } else {
+            m_head = e.next;
+        }
+        if (e.next != none) {
+            m_entries[e.next].previous = e.previous;
+        } else {
+            m_tail = e.previous;
+        }
+        e.previous = none;
+        e.next = none;
+    }
+
+    void push_front(std::size_t entry) {
+        m_entries[entry].previous = none;
+        m_entries[entry].next = m_head;
+        if (m_head != none) {
+            m_entries[m_head].previous = entry;
+        }
+        m_head = entry;
+        if (m_tail == none) {
+            m_tail = entry;
+        }
+    }
+
+    std::size_t m_page_size;
+    std::vector<Entry> m_entries;
+    std::vector<std::size_t> m_free;
+    std::map<address_t, std::size_t> m_index;
+    AlignedBuffer m_pages;
+
+    // The most and least recently used entries
+    std::size_t m_head;
+    std::size_t m_tail;
+};
+}
+}
+
+#endif
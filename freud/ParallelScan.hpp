@@ -0,0 +1,199 @@
+#ifndef FREUD_PARALLEL_SCAN
+#define FREUD_PARALLEL_SCAN
+
+#include "freud/RangeScan.hpp"
+#include "freud/ThreadPool.hpp"
+#include <vector>
+
+namespace freud {
+
+/// The default number of bytes of a region that are scanned by a single
+/// task in a parallel scan
+const std::size_t default_parallel_chunk_size = 4 * 1024 * 1024;
+
+namespace detail {
+
+/** \brief The implementation of a context's `scan_parallel`
+ *
+ * Each region is divided into chunks of 'chunk_size' bytes, and every chunk
+ * is checked by a task in a ThreadPool. The bytes read for a chunk extend
+ * past its end by enough to hold one object, so objects that span the
+ * boundary between two chunks are still found (by the earlier chunk).
+ *
+ * The counters of each chunk are kept separately and combined into the
+ * ScanStats (if requested) once every chunk has been scanned.
+ *
+ * Every worker reads into its own buffer, so the context must support
+ * concurrent calls to `read_batch` and `verify` must only use the const
+ * interface of the context.
+ */
+template <typename MemObject, typename Context, typename Callback>
+class ParallelScan {
+public:
+    typedef typename MemObject::type type;
+
+    ParallelScan(Context& ctx, Callback& callback, bool ordered)
+        : m_ctx(ctx), m_callback(callback), m_ordered(ordered),
+          m_next_to_deliver(0), m_matches(0) {}
+
+    std::size_t run(unsigned threads, std::size_t chunk_size,
+                    ScanStats* stats = NULL) {
+        const std::size_t alignment = ScanKernel<MemObject>::alignment;
+        chunk_size -= chunk_size % alignment;
+        if (chunk_size < alignment) {
+            chunk_size = alignment;
+        }
+
+        typedef typename Context::MemoryRegion MemoryRegion;
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            const MemoryRegion& region = regions[i];
+            for (address_t start = region.start_address;
+                 start < region.end_address; start += chunk_size) {
+                Chunk chunk;
+                chunk.scan = this;
+                chunk.index = m_chunks.size();
+                chunk.region = i;
+                chunk.start = start;
+                chunk.scan_end = start + chunk_size;
+                if (chunk.scan_end > region.end_address ||
+                    chunk.scan_end < start) {
+                    chunk.scan_end = region.end_address;
+                }
+                chunk.read_end = chunk.scan_end + sizeof(type) - 1;
+                if (chunk.read_end > region.end_address ||
+                    chunk.read_end < chunk.scan_end) {
+                    chunk.read_end = region.end_address;
+                }
+                chunk.finished = false;
+                m_chunks.push_back(chunk);
+            }
+        }
+
+        double started = 0;
+        FREUD_STAT(started = stats_clock());
+        ThreadPool pool(threads);
+        m_workers.resize(pool.size());
+        for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+            pool.submit(&m_chunks[i]);
+        }
+        pool.wait();
+
+        if (stats) {
+            *stats = ScanStats();
+            FREUD_STAT(stats->wall_seconds = stats_clock() - started);
+            collect_stats(regions, *stats);
+        }
+        return m_matches;
+    }
+
+private:
+    struct Chunk : public Task {
+        ParallelScan* scan;
+        std::size_t index;
+        std::size_t region;
+        address_t start;
+        address_t scan_end;
+        address_t read_end;
+
+        // Matches found in this chunk, held until they can be delivered
+        std::vector<address_t> addresses;
+        std::vector<byte_t> objects;
+        bool finished;
+
+        ScanCounters counters;
+
+        void run(unsigned worker) { scan->scan_chunk(*this, worker); }
+    };
+
+    /// Collects the matches found by the ScanKernel into a Chunk
+    struct ChunkSink {
+        Chunk* chunk;
+
+        bool operator()(address_t address, const type& object) {
+            const byte_t* bytes = reinterpret_cast<const byte_t*>(&object);
+            chunk->addresses.push_back(address);
+            chunk->objects.insert(chunk->objects.end(), bytes,
+                                  bytes + sizeof(type));
+            return true;
+        }
+    };
+
+    void scan_chunk(Chunk& chunk, unsigned worker) {
+        double started = 0;
+        FREUD_STAT(started = stats_clock());
+        ChunkSink sink = {&chunk};
+        read_and_scan<MemObject>(m_ctx, chunk.start, chunk.scan_end,
+                                 chunk.read_end, m_workers[worker], sink,
+                                 &chunk.counters);
+        FREUD_STAT(chunk.counters.matches = chunk.addresses.size());
+        FREUD_STAT(chunk.counters.seconds = stats_clock() - started);
+        deliver(chunk);
+    }
+
+    /// Combine the counters of every chunk
+    template <typename MemoryRegion>
+    void collect_stats(const std::vector<MemoryRegion>& regions,
+                       ScanStats& stats) const {
+        for (std::size_t i = 0; i < m_chunks.size();) {
+            const MemoryRegion& region = regions[m_chunks[i].region];
+            RegionStats region_stats;
+            region_stats.start_address = region.start_address;
+            region_stats.end_address = region.end_address;
+            for (; i < m_chunks.size() &&
+                   &regions[m_chunks[i].region] == &region;
+                 ++i) {
+                region_stats.add(m_chunks[i].counters);
+                region_stats.skipped |= m_chunks[i].counters.failed_reads > 0;
+            }
+            stats.add(region_stats);
+            stats.regions_skipped += region_stats.skipped ? 1 : 0;
+            if (m_ctx.region_stats()) {
+                stats.regions.push_back(region_stats);
+            }
+        }
+    }
+
+    void deliver(Chunk& chunk) {
+        ScopedLock lock(m_delivery_mutex);
+        chunk.finished = true;
+        if (!m_ordered) {
+            deliver_matches(chunk);
+            return;
+        }
+
+        // Deliver every finished chunk that has no unfinished chunk
+        // before it, so the callback sees matches in address order
+        while (m_next_to_deliver < m_chunks.size() &&
+               m_chunks[m_next_to_deliver].finished) {
+            deliver_matches(m_chunks[m_next_to_deliver]);
+            ++m_next_to_deliver;
+        }
+    }
+
+    void deliver_matches(Chunk& chunk) {
+        for (std::size_t i = 0; i < chunk.addresses.size(); ++i) {
+            m_callback(chunk.addresses[i],
+                       *reinterpret_cast<const type*>(
+                           &chunk.objects[i * sizeof(type)]));
+        }
+        m_matches += chunk.addresses.size();
+        std::vector<address_t>().swap(chunk.addresses);
+        std::vector<byte_t>().swap(chunk.objects);
+    }
+
+    Context& m_ctx;
+    Callback& m_callback;
+    bool m_ordered;
+
+    std::vector<Chunk> m_chunks;
+    std::vector<ScanScratch> m_workers;
+
+    Mutex m_delivery_mutex;
+    std::size_t m_next_to_deliver;
+    std::size_t m_matches;
+};
+}
+}
+
+#endif
@@ -0,0 +1,305 @@
+#ifndef FREUD_POINTER_INDEX
+#define FREUD_POINTER_INDEX
+
+#include "freud/MemoryObject.hpp"
+#include "freud/ParallelScan.hpp"
+#include "freud/RangeScan.hpp"
+#include "freud/ThreadPool.hpp"
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace freud {
+
+/// The default limit on the number of pointers held by a PointerIndex
+/// (each of which takes two addresses of memory)
+const std::size_t default_pointer_index_limit = 64 * 1024 * 1024;
+
+/// A pointer found in a context: the word at 'source' holds 'target'
+struct PointerEntry {
+    address_t target;
+    address_t source;
+};
+
+namespace detail {
+
+/// Matches aligned words that point into a mapped region of the context
+struct PointerValue : public MemoryObject<address_t> {
+    template <typename Context>
+    static bool verify(const Context& ctx, const address_t& value,
+                       address_t) {
+        return ctx.contains_address(value);
+    }
+};
+
+inline bool pointer_entry_less(const PointerEntry& left,
+                               const PointerEntry& right) {
+    return left.target < right.target ||
+           (left.target == right.target && left.source < right.source);
+}
+
+inline bool target_before(const PointerEntry& entry, address_t address) {
+    return entry.target < address;
+}
+
+inline bool target_after(address_t address, const PointerEntry& entry) {
+    return address < entry.target;
+}
+
+/** \brief The implementation of PointerIndex::build
+ *
+ * Like a ParallelScan, each region is divided into chunks that are scanned
+ * by a ThreadPool. Each chunk collects and sorts its own pointers, and the
+ * sorted runs are then merged in rounds, with the merges of each round
+ * also run by the pool.
+ */
+template <typename Context>
+class PointerIndexBuild {
+public:
+    PointerIndexBuild(Context& ctx, std::size_t limit)
+        : m_ctx(ctx), m_remaining(limit), m_truncated(false) {}
+
+    bool run(unsigned threads, std::size_t chunk_size,
+             std::vector<PointerEntry>& entries) {
+        chunk_size -= chunk_size % sizeof(address_t);
+        if (chunk_size < sizeof(address_t)) {
+            chunk_size = sizeof(address_t);
+        }
+
+        typedef typename Context::MemoryRegion MemoryRegion;
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            const address_t end = regions[i].end_address;
+            for (address_t start = regions[i].start_address; start < end;
+                 start += chunk_size) {
+                Chunk chunk;
+                chunk.build = this;
+                chunk.start = start;
+                chunk.scan_end = start + chunk_size;
+                if (chunk.scan_end > end || chunk.scan_end < start) {
+                    chunk.scan_end = end;
+                }
+                chunk.read_end = chunk.scan_end + sizeof(address_t) - 1;
+                if (chunk.read_end > end || chunk.read_end < chunk.scan_end) {
+                    chunk.read_end = end;
+                }
+                m_chunks.push_back(chunk);
+            }
+        }
+
+        ThreadPool pool(threads);
+        m_workers.resize(pool.size());
+        for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+            pool.submit(&m_chunks[i]);
+        }
+        pool.wait();
+
+        // Concatenate the sorted runs, releasing each chunk's memory as
+        // it is copied
+        std::size_t total = 0;
+        for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+            total += m_chunks[i].entries.size();
+        }
+        entries.clear();
+        entries.reserve(total);
+        std::vector<std::size_t> bounds(1, 0);
+        for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+            if (m_chunks[i].entries.empty()) {
+                continue;
+            }
+            entries.insert(entries.end(), m_chunks[i].entries.begin(),
+                           m_chunks[i].entries.end());
+            std::vector<PointerEntry>().swap(m_chunks[i].entries);
+            bounds.push_back(entries.size());
+        }
+
+        // Merge adjacent runs until one is left
+        while (bounds.size() > 2) {
+            std::vector<Merge> merges;
+            std::vector<std::size_t> next_bounds(1, 0);
+            for (std::size_t i = 0; i + 1 < bounds.size(); i += 2) {
+                if (i + 2 < bounds.size()) {
+                    Merge merge;
+                    merge.entries = &entries;
+                    merge.first = bounds[i];
+                    merge.middle = bounds[i + 1];
+                    merge.last = bounds[i + 2];
+                    merges.push_back(merge);
+                    next_bounds.push_back(bounds[i + 2]);
+                } else {
+                    next_bounds.push_back(bounds[i + 1]);
+                }
+            }
+            for (std::size_t i = 0; i < merges.size(); ++i) {
+                pool.submit(&merges[i]);
+            }
+            pool.wait();
+            bounds.swap(next_bounds);
+        }
+        return !m_truncated;
+    }
+
+private:
+    struct Chunk : public Task {
+        PointerIndexBuild* build;
+        address_t start;
+        address_t scan_end;
+        address_t read_end;
+        std::vector<PointerEntry> entries;
+
+        void run(unsigned worker) { build->scan_chunk(*this, worker); }
+    };
+
+    struct Merge : public Task {
+        std::vector<PointerEntry>* entries;
+        std::size_t first;
+        std::size_t middle;
+        std::size_t last;
+
+        void run(unsigned) {
+            std::inplace_merge(entries->begin() + first,
+                               entries->begin() + middle,
+                               entries->begin() + last, &pointer_entry_less);
+        }
+    };
+
+    struct ChunkSink {
+        Chunk* chunk;
+
+        bool operator()(address_t address, const address_t& value) {
+            const PointerEntry entry = {value, address};
+            chunk->entries.push_back(entry);
+            return true;
+        }
+    };
+
+    void scan_chunk(Chunk& chunk, unsigned worker) {
+        {
+            ScopedLock lock(m_mutex);
+            if (m_remaining == 0) {
+                m_truncated = true;
+                return;
+            }
+        }
+
+        ChunkSink sink = {&chunk};
+        read_and_scan<PointerValue>(m_ctx, chunk.start, chunk.scan_end,
+                                    chunk.read_end, m_workers[worker], sink);
+        std::sort(chunk.entries.begin(), chunk.entries.end(),
+                  &pointer_entry_less);
+
+        // Keep the pointers that fit within the limit
+        ScopedLock lock(m_mutex);
+        if (chunk.entries.size() > m_remaining) {
+            chunk.entries.resize(m_remaining);
+            std::vector<PointerEntry>(chunk.entries).swap(chunk.entries);
+            m_truncated = true;
+        }
+        m_remaining -= chunk.entries.size();
+    }
+
+    Context& m_ctx;
+    std::vector<Chunk> m_chunks;
+    std::vector<ScanScratch> m_workers;
+
+    Mutex m_mutex;
+    std::size_t m_remaining;
+    bool m_truncated;
+};
+}
+
+/** \brief An index of the pointers held by a context, by target
+ *
+ * A PointerIndex answers "which words point to X?" without scanning the
+ * context again. Building it scans every region of the context once, with
+ * several threads, and records each aligned, pointer sized word whose
+ * value lies in one of the context's mapped regions. Each pointer is
+ * stored as a (target, source) pair, sorted by target, so the pointers to
+ * an address, or into a range of addresses, are found with a binary
+ * search:
+ *
+ * \code{.c}
+ * PointerIndex index;
+ * index.build(ctx, 8);
+ *
+ * PointerIndex::Range refs = index.referrers(address);
+ * for (; refs.first != refs.second; ++refs.first) {
+ *     std::cout << std::hex << refs.first->source << "\n";
+ * }
+ * \endcode
+ *
+ * The index is a snapshot of the context at the time it was built. The
+ * number of pointers held is bounded (see build); if there are more, the
+ * index only holds some of them, and `complete` returns false.
+ */
+class PointerIndex {
+public:
+    typedef std::vector<PointerEntry>::const_iterator const_iterator;
+    typedef std::pair<const_iterator, const_iterator> Range;
+
+    PointerIndex() : m_complete(true) {}
+
+    /// Index the pointers held by every region of a context
+    /**
+     * The regions are scanned in chunks of 'chunk_size' bytes by a pool of
+     * 'threads' workers, so the context must support concurrent calls to
+     * `read_batch` (see LinuxMemoryContext::scan_parallel). At most 'limit'
+     * pointers are kept.
+     *
+     * \returns true if every pointer was indexed
+     */
+    template <typename Context>
+    bool build(Context& ctx, unsigned threads = 1,
+               std::size_t limit = default_pointer_index_limit,
+               std::size_t chunk_size = default_parallel_chunk_size) {
+        std::vector<PointerEntry>().swap(m_entries);
+        detail::PointerIndexBuild<Context> build(ctx, limit);
+        m_complete = build.run(threads, chunk_size, m_entries);
+        return m_complete;
+    }
+
+    /// The pointers whose target is 'address'
+    Range referrers(address_t address) const {
+        return Range(std::lower_bound(m_entries.begin(), m_entries.end(),
+                                      address, &detail::target_before),
+                     std::upper_bound(m_entries.begin(), m_entries.end(),
+                                      address, &detail::target_after));
+    }
+
+    /// The pointers whose target is in [start, end)
+    Range referrers(address_t start, address_t end) const {
+        return Range(std::lower_bound(m_entries.begin(), m_entries.end(),
+                                      start, &detail::target_before),
+                     std::lower_bound(m_entries.begin(), m_entries.end(), end,
+                                      &detail::target_before));
+    }
+
+    /// Test whether any pointer targets 'address'
+    bool is_referenced(address_t address) const {
+        Range range = referrers(address);
+        return range.first != range.second;
+    }
+
+    /// Every pointer, in order of target (and then source)
+    const_iterator begin() const { return m_entries.begin(); }
+    const_iterator end() const { return m_entries.end(); }
+
+    /// The number of pointers in the index
+    std::size_t size() const { return m_entries.size(); }
+
+    /// False if the last build found more pointers than its limit
+    bool complete() const { return m_complete; }
+
+    /// Free the memory held by the index
+    void clear() {
+        std::vector<PointerEntry>().swap(m_entries);
+        m_complete = true;
+    }
+
+private:
+    std::vector<PointerEntry> m_entries;
+    bool m_complete;
+};
+}
+
+#endif
@@ -0,0 +1,242 @@
+#ifndef FREUD_PREFETCHER
+#define FREUD_PREFETCHER
+
+#include "freud/AlignedBuffer.hpp"
+#include "freud/LinuxReadBackend.hpp"
+#include "freud/ThreadPool.hpp"
+#include <pthread.h>
+#include <vector>
+
+namespace freud {
+namespace detail {
+
+/** \brief Reads ranges of target memory ahead of time on a background thread
+ *
+ * A context uses a Prefetcher to read the next windows of memory while the
+ * current window is being scanned. Up to 'depth' reads may be queued at
+ * once, each into its own buffer. The background thread performs them in
+ * the order they were started, and the caller collects them in the same
+ * order with `finish`. Once every buffer holds a read that has not been
+ * collected, no more reads can be started (see full), so the reader can
+ * never get more than 'depth' reads ahead of the scan.
+ *
+ * Each read's bytes are placed 'headroom' bytes from the beginning of its
+ * buffer, so the caller can prepend the unscanned tail of the previous
+ * window without moving the prefetched bytes.
+ *
+ * The background thread is only created when the first read is started.
+ * If it cannot be created, each read is made by `finish` instead.
+ */
+template <typename Context>
+class Prefetcher {
+public:
+    explicit Prefetcher(Context& ctx, std::size_t depth = 1)
+        : m_ctx(ctx), m_started(false), m_tried_start(false),
+          m_stopping(false), m_busy(false),
+          m_head(0), m_queued(0), m_completed(0), m_collected(0) {
+        resize(depth < 1 ? 1 : depth);
+    }
+
+    ~Prefetcher() {
+        if (m_started) {
+            {
+                ScopedLock lock(m_mutex);
+                m_stopping = true;
+                m_request_ready.signal();
+            }
+            pthread_join(m_thread, NULL);
+        }
+        resize(0);
+    }
+
+    /// The most reads that may be queued at once
+    std::size_t depth() const { return m_slots.size(); }
+
+    /// Change the number of reads that may be queued at once. Any pending
+    /// reads are cancelled.
+    void set_depth(std::size_t depth) {
+        cancel();
+        resize(depth < 1 ? 1 : depth);
+        m_collected = 0;
+    }
+
+    /// Queue a read of 'size' bytes at 'address'. This must not be called
+    /// while the queue is full.
+    void start(address_t address, std::size_t size, std::size_t headroom) {
+        if (!m_tried_start) {
+            m_tried_start = true;
+            m_started = pthread_create(&m_thread, NULL,
+                                       &Prefetcher::thread_main, this) == 0;
+        }
+
+        ScopedLock lock(m_mutex);
+        Slot& slot = *m_slots[(m_head + m_queued) % m_slots.size()];
+        slot.buffer.resize(headroom + size);
+        slot.address = address;
+        slot.size = size;
+        slot.headroom = headroom;
+        ++m_queued;
+        m_request_ready.signal();
+    }
+
+    /// True if a read has been started and not yet collected or cancelled
+    bool pending() const { return m_queued != 0; }
+
+    /// True if no more reads can be started until one is collected
+    bool full() const { return m_queued == m_slots.size(); }
+
+    /// The first address of the oldest pending read
+    address_t address() const { return front().address; }
+
+    /// The number of bytes in the oldest pending read
+    std::size_t size() const { return front().size; }
+
+    /// The offset in buffer() at which the bytes of the oldest pending read
+    /// are placed
+    std::size_t headroom() const { return front().headroom; }
+
+    /// The address just past the newest pending read
+    address_t end_address() const {
+        const Slot& back =
+            *m_slots[(m_head + m_queued - 1) % m_slots.size()];
+        return back.address + back.size;
+    }
+
+    /// Wait for the oldest pending read to finish and collect it
+    /**
+     * Its bytes are then available in buffer().
+     *
+     * \returns true if every byte was read. Either way, the read is no
+     *          longer pending afterwards.
+     */
+    bool finish() {
+        if (!m_started) {
+            // There is no background thread, so make the read now
+            Slot& slot = *m_slots[m_head];
+            std::vector<ReadRequest> requests(1);
+            ReadRequest request = {slot.address,
+                                   slot.buffer.data() + slot.headroom,
+                                   slot.size, 0};
+            requests[0] = request;
+            slot.result = m_ctx.read_batch(requests);
+            ++m_completed;
+        }
+
+        ScopedLock lock(m_mutex);
+        while (m_completed == 0) {
+            m_request_done.wait(m_mutex);
+        }
+        m_collected = m_head;
+        m_head = (m_head + 1) % m_slots.size();
+        --m_queued;
+        --m_completed;
+        return m_slots[m_collected]->result;
+    }
+
+    /// Discard every pending read
+    void cancel() {
+        ScopedLock lock(m_mutex);
+        while (m_busy) {
+            m_request_done.wait(m_mutex);
+        }
+        m_queued = 0;
+        m_completed = 0;
+    }
+
+    /// The buffer holding the read most recently collected by `finish`.
+    /// It may be modified (or swapped) until the next read is started.
+    AlignedBuffer& buffer() { return m_slots[m_collected]->buffer; }
+
+private:
+    Prefetcher(const Prefetcher&);
+    Prefetcher& operator=(const Prefetcher&);
+
+    struct Slot {
+        AlignedBuffer buffer;
+        address_t address;
+        std::size_t size;
+        std::size_t headroom;
+        bool result;
+
+        Slot() : address(0), size(0), headroom(0), result(false) {}
+    };
+
+    const Slot& front() const { return *m_slots[m_head]; }
+
+    void resize(std::size_t depth) {
+        for (std::size_t i = depth; i < m_slots.size(); ++i) {
+            delete m_slots[i];
+        }
+        const std::size_t old_depth = m_slots.size();
+        m_slots.resize(depth);
+        for (std::size_t i = old_depth; i < depth; ++i) {
+            m_slots[i] = new Slot();
+        }
+        m_head = 0;
+    }
+
+    static void* thread_main(void* arg) {
+        static_cast<Prefetcher*>(arg)->run();
+        return NULL;
+    }
+
+    void run() {
+        std::vector<ReadRequest> requests(1);
+        for (;;) {
+            Slot* slot;
+            {
+                ScopedLock lock(m_mutex);
+                while (m_completed == m_queued && !m_stopping) {
+                    m_request_ready.wait(m_mutex);
+                }
+                if (m_stopping) {
+                    return;
+                }
+                slot = m_slots[(m_head + m_completed) % m_slots.size()];
+                ReadRequest request = {slot->address,
+                                       slot->buffer.data() + slot->headroom,
+                                       slot->size, 0};
+                requests[0] = request;
+                m_busy = true;
+            }
+
+            bool result = m_ctx.read_batch(requests);
+
+            ScopedLock lock(m_mutex);
+            slot->result = result;
+            m_busy = false;
+            ++m_completed;
+            m_request_done.broadcast();
+        }
+    }
+
+    Context& m_ctx;
+    std::vector<Slot*> m_slots;
+
+    pthread_t m_thread;
+    Mutex m_mutex;
+    Condition m_request_ready;
+    Condition m_request_done;
+    // Whether the background thread is running, and whether creating it
+    // has been attempted
+    bool m_started;
+    bool m_tried_start;
+    bool m_stopping;
+
+    // Whether the background thread is reading into a slot
+    bool m_busy;
+
+    // The slots form a ring. m_queued reads starting at m_head have been
+    // started and not collected, and the first m_completed of those have
+    // been read.
+    std::size_t m_head;
+    std::size_t m_queued;
+    std::size_t m_completed;
+
+    // The slot most recently collected by finish
+    std::size_t m_collected;
+};
+}
+}
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef FREUD_PREFILTER
+#define FREUD_PREFILTER
+
+#include "freud/Anchor.hpp"
+#include "freud/Defines.hpp"
+#include <cstring>
+#include <vector>
+
+#if !defined FREUD_NO_SIMD && (defined __GNUC__ || defined __clang__) &&      \
+    (defined __x86_64__ || defined __i386__)
+#define FREUD_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace freud {
+namespace detail {
+
+/** \brief Signature of the byte search kernels
+ *
+ * Returns the smallest index 'i' in [pos, end) for which `data[i] == value`
+ * and `i % stride == phase`, or 'end' if there is none. 'stride' must be a
+ * power of two no larger than 64.
+ */
+typedef std::size_t (*FindByteFunction)(const byte_t* data, std::size_t pos,
+                                        std::size_t end, unsigned char value,
+                                        std::size_t stride, std::size_t phase);
+
+/// A 64 bit mask with bit 'i' set for every 'i' that is a multiple of stride
+inline uint64_t stride_mask(std::size_t stride) {
+    uint64_t mask = 0;
+    for (std::size_t i = 0; i < 64; i += stride) {
+        mask |= uint64_t(1) << i;
+    }
+    return mask;
+}
+
+/// The stride mask for the block starting at 'pos'
+inline uint64_t block_mask(uint64_t stride_bits, std::size_t stride,
+                           std::size_t pos, std::size_t phase) {
+    return stride_bits << ((phase - pos) & (stride - 1));
+}
+
+inline unsigned lowest_bit(uint64_t mask) {
+#if defined __GNUC__ || defined __clang__
+    return __builtin_ctzll(mask);
+#else
+    unsigned bit = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+#endif
+}
+
+inline std::size_t find_byte_tail(const byte_t* data, std::size_t pos,
+                                  std::size_t end, unsigned char value,
+                                  std::size_t stride, std::size_t phase) {
+    pos += (phase - pos) & (stride - 1);
+    for (; pos < end; pos += stride) {
+        if (static_cast<unsigned char>(data[pos]) == value) {
+            return pos;
+        }
+    }
+    return end;
+}
+
+/// The portable kernel, built on memchr
+inline std::size_t find_byte_scalar(const byte_t* data, std::size_t pos,
+                                    std::size_t end, unsigned char value,
+                                    std::size_t stride, std::size_t phase) {
+    while (pos < end) {
+        const void* found = std::memchr(data + pos, value, end - pos);
+        if (!found) {
+            return end;
+        }
+        pos = static_cast<const byte_t*>(found) - data;
+        if ((pos & (stride - 1)) == phase) {
+            return pos;
+        }
+        ++pos;
+    }
+    return end;
+}
+
+#ifdef FREUD_X86_SIMD
+__attribute__((target("sse2"))) inline std::size_t
+find_byte_sse2(const byte_t* data, std::size_t pos, std::size_t end,
+               unsigned char value, std::size_t stride, std::size_t phase) {
+    const __m128i needle = _mm_set1_epi8(static_cast<char>(value));
+    const uint64_t stride_bits = stride_mask(stride);
+
+    for (; pos + 64 <= end; pos += 64) {
+        const __m128i* block = reinterpret_cast<const __m128i*>(data + pos);
+        uint64_t m0 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(block), needle)));
+        uint64_t m1 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(block + 1), needle)));
+        uint64_t m2 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(block + 2), needle)));
+        uint64_t m3 = static_cast<uint32_t>(_mm_movemask_epi8(
+            _mm_cmpeq_epi8(_mm_loadu_si128(block + 3), needle)));
+        uint64_t mask = m0 | (m1 << 16) | (m2 << 32) | (m3 << 48);
+        mask &= block_mask(stride_bits, stride, pos, phase);
+        if (mask) {
+            return pos + lowest_bit(mask);
+        }
+    }
+    return find_byte_tail(data, pos, end, value, stride, phase);
+}
+
+__attribute__((target("avx2"))) inline std::size_t
+find_byte_avx2(const byte_t* data, std::size_t pos, std::size_t end,
+               unsigned char value, std::size_t stride, std::size_t phase) {
+    const __m256i needle = _mm256_set1_epi8(static_cast<char>(value));
+    const uint64_t stride_bits = stride_mask(stride);
+
+    for (; pos + 64 <= end; pos += 64) {
+        const __m256i* block = reinterpret_cast<const __m256i*>(data + pos);
+        uint64_t low = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(block), needle)));
+        uint64_t high = static_cast<uint32_t>(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(_mm256_loadu_si256(block + 1), needle)));
+        uint64_t mask = low | (high << 32);
+        mask &= block_mask(stride_bits, stride, pos, phase);
+        if (mask) {
+            return pos + lowest_bit(mask);
+        }
+    }
+    return find_byte_tail(data, pos, end, value, stride, phase);
+}
+#endif
+
+/// Choose the fastest byte search kernel supported by this CPU
+inline FindByteFunction select_find_byte() {
+#ifdef FREUD_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &find_byte_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return &find_byte_sse2;
+    }
+#endif
+    return &find_byte_scalar;
+}
+
+/// Find the next 'value' byte at the given phase (see FindByteFunction)
+inline std::size_t find_byte(const byte_t* data, std::size_t pos,
+                             std::size_t end, unsigned char value,
+                             std::size_t stride, std::size_t phase) {
+    static const FindByteFunction function = select_find_byte();
+    return function(data, pos, end, value, stride, phase);
+}
+
+/** \brief The anchors of a MemObject, prepared for scanning
+ *
+ * One fully specified byte of the anchors is chosen as the 'probe'. A scan
+ * searches for the probe byte with find_byte, and only the offsets where it
+ * appears are checked against the remaining anchors and then verified.
+ * Zero bytes are avoided as probes where possible, since they are common
+ * in most memory.
+ */
+template <typename MemObject>
+class Prefilter {
+public:
+    typedef typename MemObject::type type;
+
+    static const Prefilter& instance() {
+        static const Prefilter prefilter;
+        return prefilter;
+    }
+
+    /// True if the MemObject declared no usable anchors
+    bool empty() const { return m_anchors.empty(); }
+
+    /// True if a probe byte is available for find_byte
+    bool has_probe() const { return m_has_probe; }
+
+    /// The offset within the object of the probe byte
+    std::size_t probe_offset() const { return m_probe_offset; }
+
+    /// The value of the probe byte
+    unsigned char probe_value() const { return m_probe_value; }
+
+    /// Test every anchor against the object starting at 'object'
+    bool matches(const byte_t* object) const {
+        for (std::size_t i = 0; i < m_anchors.size(); ++i) {
+            const Anchor& anchor = m_anchors[i];
+            uint64_t field = 0;
+            std::memcpy(&field, object + anchor.offset, anchor.size);
+            if ((field & anchor.mask) != anchor.value) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    Prefilter() : m_has_probe(false), m_probe_offset(0), m_probe_value(0) {
+        std::vector<Anchor> anchors;
+        MemObject::anchors(anchors);
+
+        bool probe_is_zero = true;
+        for (std::size_t i = 0; i < anchors.size(); ++i) {
+            Anchor anchor = anchors[i];
+            if (anchor.size == 0 || anchor.size > sizeof(uint64_t) ||
+                anchor.offset + anchor.size > sizeof(type)) {
+                continue;
+            }
+            anchor.value &= anchor.mask;
+            m_anchors.push_back(anchor);
+
+            const unsigned char* mask =
+                reinterpret_cast<const unsigned char*>(&anchor.mask);
+            const unsigned char* value =
+                reinterpret_cast<const unsigned char*>(&anchor.value);
+            for (std::size_t b = 0; b < anchor.size; ++b) {
+                if (mask[b] != 0xFF || (m_has_probe && value[b] == 0) ||
+                    (m_has_probe && !probe_is_zero)) {
+                    continue;
+                }
+                m_has_probe = true;
+                m_probe_offset = anchor.offset + b;
+                m_probe_value = value[b];
+                probe_is_zero = value[b] == 0;
+            }
+        }
+    }
+
+    std::vector<Anchor> m_anchors;
+    bool m_has_probe;
+    std::size_t m_probe_offset;
+    unsigned char m_probe_value;
+};
+}
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef FREUD_PROCESS_PAUSE
+#define FREUD_PROCESS_PAUSE
+
+#include <cerrno>
+#include <cstdlib>
+#include <dirent.h>
+#include <signal.h>
+#include <sstream>
+#include <sys/ptrace.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <vector>
+
+namespace freud {
+namespace detail {
+
+/** \brief Stops every thread of a process with ptrace
+ *
+ * Each thread is attached with PTRACE_SEIZE and stopped with
+ * PTRACE_INTERRUPT, which (unlike SIGSTOP) is invisible to the target and
+ * its parent. The threads are listed again until no new ones appear, so
+ * threads created while the others were being stopped are caught too.
+ * `resume` detaches from every thread, delivering any signal that arrived
+ * while it was stopped. The destructor resumes the process if needed.
+ */
+class ProcessPause {
+public:
+    ProcessPause() {}
+
+    ~ProcessPause() { resume(); }
+
+    /// Stop every thread of 'pid'
+    /**
+     * \returns false if a thread could not be attached (for example,
+     *          because the process is already being traced), in which case
+     *          no thread is left stopped
+     */
+    bool stop(unsigned long pid) {
+        resume();
+        std::ostringstream path;
+        path << "/proc/" << pid << "/task";
+
+        for (bool added = true; added;) {
+            added = false;
+            DIR* tasks = opendir(path.str().c_str());
+            if (!tasks) {
+                break;
+            }
+            while (dirent* entry = readdir(tasks)) {
+                char* end;
+                pid_t tid = std::strtoul(entry->d_name, &end, 10);
+                if (*end != '\0' || end == entry->d_name || is_stopped(tid)) {
+                    continue;
+                }
+                if (ptrace(PTRACE_SEIZE, tid, NULL, NULL) != 0) {
+                    if (errno == ESRCH) {
+                        // The thread has already exited
+                        continue;
+                    }
+                    closedir(tasks);
+                    resume();
+                    return false;
+                }
+                ptrace(PTRACE_INTERRUPT, tid, NULL, NULL);
+
+                int status;
+                if (waitpid(tid, &status, __WALL) != tid ||
+                    !WIFSTOPPED(status)) {
+                    // The thread exited before it could be stopped
+                    continue;
+                }
+
+                // A thread may stop to receive a signal rather than for the
+                // interrupt. The signal is delivered when it is resumed.
+                Thread thread = {tid, 0};
+                if ((status >> 16) == 0) {
+                    thread.signal = WSTOPSIG(status);
+                }
+                m_threads.push_back(thread);
+                added = true;
+            }
+            closedir(tasks);
+        }
+        return !m_threads.empty();
+    }
+
+    /// Let every stopped thread run again
+    void resume() {
+        for (std::size_t i = 0; i < m_threads.size(); ++i) {
+            ptrace(PTRACE_DETACH, m_threads[i].tid, NULL,
+                   reinterpret_cast<void*>(long(m_threads[i].signal)));
+        }
+        m_threads.clear();
+    }
+
+    /// True while the process is stopped
+    bool stopped() const { return !m_threads.empty(); }
+
+private:
+    ProcessPause(const ProcessPause&);
+    ProcessPause& operator=(const ProcessPause&);
+
+    struct Thread {
+        pid_t tid;
+        int signal;
+    };
+
+    bool is_stopped(pid_t tid) const {
+        for (std::size_t i = 0; i < m_threads.size(); ++i) {
+            if (m_threads[i].tid == tid) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Thread> m_threads;
+};
+}
+}
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef FREUD_RANGE_SCAN
+#define FREUD_RANGE_SCAN
+
+#include "freud/LinuxReadBackend.hpp"
+#include "freud/ScanKernel.hpp"
+#include <algorithm>
+#include <vector>
+
+namespace freud {
+namespace detail {
+
+/// Buffers used to read and scan a range of a context
+struct ScanScratch {
+    std::vector<byte_t> buffer;
+    std::vector<ReadRequest> requests;
+    std::vector<FailedRange> failed;
+};
+
+/** \brief Direct access to the memory of a context
+ *
+ * Contexts whose memory is already present in this process (such as a
+ * SnapshotMemoryContext) specialize this to return a pointer to the bytes
+ * [address, address + size), so they can be scanned without being copied.
+ * The pointer must stay valid for as long as the context's regions do not
+ * change. NULL means the bytes must be read with `read_batch`.
+ */
+template <typename Context>
+struct InPlaceAccess {
+    static const byte_t* data(const Context&, address_t, std::size_t) {
+        return NULL;
+    }
+};
+
+/** \brief Read the bytes [start, start + length) of a region
+ *
+ * The bytes are read into 'scratch' with `ctx.read_batch`, unless the
+ * context provides InPlaceAccess to them. The page ranges that could not
+ * be read are left in 'scratch.failed'. The work done is added to
+ * 'counters' (if given).
+ *
+ * \returns A pointer to the bytes, which is valid until 'scratch' is
+ *          reused
+ */
+template <typename Context>
+const byte_t* read_range(Context& ctx, address_t start, std::size_t length,
+                         ScanScratch& scratch, ScanCounters* counters = NULL) {
+    scratch.failed.clear();
+    if (const byte_t* data = InPlaceAccess<Context>::data(ctx, start, length)) {
+        FREUD_STAT(if (counters) {
+            counters->bytes_requested += length;
+            counters->bytes_read += length;
+        });
+        return data;
+    }
+    scratch.buffer.resize(length);
+
+    ReadRequest request = {start, &scratch.buffer[0], length, 0};
+    scratch.requests.assign(1, request);
+    ctx.read_batch(scratch.requests, &scratch.failed, counters);
+    return &scratch.buffer[0];
+}
+
+/** \brief Scan the readable parts of bytes returned by read_range
+ *
+ * Every object that starts in [start, start + scan_length) and lies
+ * entirely outside of the 'failed' ranges is passed to the ScanKernel.
+ * 'start' must be at an aligned offset from the start of its region.
+ */
+template <typename MemObject, typename Context, typename Sink>
+void scan_readable(const Context& ctx, const byte_t* data, address_t start,
+                   std::size_t length, std::size_t scan_length,
+                   const std::vector<FailedRange>& failed, Sink& sink,
+                   ScanCounters* counters = NULL) {
+    // Only check objects lying entirely in bytes that were readable
+    const std::size_t alignment = ScanKernel<MemObject>::alignment;
+    std::size_t segment_start = 0;
+    for (std::size_t i = 0; i <= failed.size(); ++i) {
+        std::size_t segment_end = length;
+        std::size_t next_start = length;
+        if (i < failed.size()) {
+            segment_end = failed[i].start_address - start;
+            next_start = failed[i].end_address - start;
+        }
+        std::size_t begin = segment_start + alignment - 1;
+        begin -= begin % alignment;
+
+        ScanKernel<MemObject>::scan(ctx, data, segment_end, start, begin,
+                                    std::min(scan_length, segment_end), sink,
+                                    counters);
+        segment_start = next_start;
+    }
+}
+
+/** \brief Read part of a region and scan it
+ *
+ * The bytes [start, read_end) are read with read_range, and every object
+ * that starts in [start, scan_end) and lies entirely within the bytes that
+ * could be read is passed to the ScanKernel. 'start' must be at an aligned
+ * offset from the start of its region. The sink should always return true,
+ * as the scan cannot be resumed part way through. The work done is added
+ * to 'counters' (if given).
+ */
+template <typename MemObject, typename Context, typename Sink>
+void read_and_scan(Context& ctx, address_t start, address_t scan_end,
+                   address_t read_end, ScanScratch& scratch, Sink& sink,
+                   ScanCounters* counters = NULL) {
+    const std::size_t length = read_end - start;
+    if (length == 0) {
+        return;
+    }
+    const byte_t* data = read_range(ctx, start, length, scratch, counters);
+    scan_readable<MemObject>(ctx, data, start, length, scan_end - start,
+                             scratch.failed, sink, counters);
+}
+
+/** \brief Scan the objects starting in [start, end) of a region
+ *
+ * The range is read 'chunk_size' bytes at a time (plus enough bytes to
+ * hold an object that starts at the end of a chunk). 'region_end' is the
+ * end of the region containing the range; no bytes past it are read.
+ */
+template <typename MemObject, typename Context, typename Sink>
+void scan_range(Context& ctx, address_t start, address_t end,
+                address_t region_end, std::size_t chunk_size,
+                ScanScratch& scratch, Sink& sink) {
+    const std::size_t alignment = ScanKernel<MemObject>::alignment;
+    const std::size_t size = sizeof(typename MemObject::type);
+    chunk_size -= chunk_size % alignment;
+    if (chunk_size < alignment) {
+        chunk_size = alignment;
+    }
+
+    for (address_t chunk = start; chunk < end; chunk += chunk_size) {
+        address_t scan_end = chunk + chunk_size;
+        if (scan_end > end || scan_end < chunk) {
+            scan_end = end;
+        }
+        address_t read_end = scan_end + size - 1;
+        if (read_end > region_end || read_end < scan_end) {
+            read_end = region_end;
+        }
+        read_and_scan<MemObject>(ctx, chunk, scan_end, read_end, scratch,
+                                 sink);
+    }
+}
+}
+}
+
+#endif
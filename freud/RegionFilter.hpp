@@ -0,0 +1,129 @@
+#ifndef FREUD_REGION_FILTER
+#define FREUD_REGION_FILTER
+
+#include <string>
+#include <vector>
+
+namespace freud {
+
+/// Access permissions of a MemoryRegion (combined as a bit mask)
+enum RegionPermission {
+    REGION_READ = 1,
+    REGION_WRITE = 2,
+    REGION_EXECUTE = 4,
+
+    /// The mapping is shared with other processes (rather than private)
+    REGION_SHARED = 8
+};
+
+/** \brief Selects the regions of a process that a context should read
+ *
+ * A region is accepted if it has all of the 'required' permissions, none
+ * of the 'excluded' permissions, and (if any names or anonymous() were
+ * given) it is anonymous or its name matches one of the names. A name
+ * ending with '*' matches any name that starts with the text before the
+ * '*'. For example, the following filter accepts the private writable
+ * heap, stack and anonymous regions:
+ *
+ * \code{.cpp}
+ * RegionFilter filter = RegionFilter()
+ *                           .require(REGION_READ | REGION_WRITE)
+ *                           .exclude(REGION_SHARED)
+ *                           .anonymous()
+ *                           .name("[heap]")
+ *                           .name("[stack*");
+ * \endcode
+ *
+ * This particular filter is also available as RegionFilter::writable_data.
+ * A default constructed RegionFilter accepts every region.
+ */
+class RegionFilter {
+public:
+    RegionFilter() : m_required(0), m_excluded(0), m_anonymous(false) {}
+
+    /// Only accept regions with all of the given permissions
+    RegionFilter& require(unsigned permissions) {
+        m_required |= permissions;
+        return *this;
+    }
+
+    /// Only accept regions with none of the given permissions
+    RegionFilter& exclude(unsigned permissions) {
+        m_excluded |= permissions;
+        return *this;
+    }
+
+    /// Accept regions with the given name (see the class description)
+    RegionFilter& name(const std::string& pattern) {
+        m_names.push_back(pattern);
+        return *this;
+    }
+
+    /// Accept anonymous regions (those with no name)
+    RegionFilter& anonymous() {
+        m_anonymous = true;
+        return *this;
+    }
+
+    /// Private, writable heap, stack and anonymous regions. These hold
+    /// almost all dynamically created objects.
+    static RegionFilter writable_data() {
+        return RegionFilter()
+            .require(REGION_READ | REGION_WRITE)
+            .exclude(REGION_SHARED)
+            .anonymous()
+            .name("[heap]")
+            .name("[stack*");
+    }
+
+    /// Only the heap
+    static RegionFilter heap_only() { return RegionFilter().name("[heap]"); }
+
+    /// Test whether a region with the given properties is accepted
+    bool accepts(const char* name, std::size_t name_length,
+                 unsigned permissions) const {
+        if ((permissions & m_required) != m_required ||
+            (permissions & m_excluded) != 0) {
+            return false;
+        }
+        if (!m_anonymous && m_names.empty()) {
+            return true;
+        }
+        if (m_anonymous && name_length == 0) {
+            return true;
+        }
+        for (std::size_t i = 0; i < m_names.size(); ++i) {
+            if (matches(m_names[i], name, name_length)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// Test whether a MemoryRegion is accepted
+    template <typename MemoryRegion>
+    bool accepts(const MemoryRegion& region) const {
+        return accepts(region.name.data(), region.name.size(),
+                       region.permissions);
+    }
+
+private:
+    static bool matches(const std::string& pattern, const char* name,
+                        std::size_t name_length) {
+        if (!pattern.empty() && pattern[pattern.size() - 1] == '*') {
+            std::size_t prefix = pattern.size() - 1;
+            return name_length >= prefix &&
+                   pattern.compare(0, prefix, name, prefix) == 0;
+        }
+        return pattern.size() == name_length &&
+               pattern.compare(0, name_length, name, name_length) == 0;
+    }
+
+    unsigned m_required;
+    unsigned m_excluded;
+    bool m_anonymous;
+    std::vector<std::string> m_names;
+};
+}
+
+#endif
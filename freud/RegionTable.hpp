@@ -0,0 +1,301 @@
+#ifndef FREUD_REGION_TABLE
+#define FREUD_REGION_TABLE
+
+#include "freud/Defines.hpp"
+#include "freud/RegionFilter.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#if defined _MSC_VER
+#include <windows.h>
+#endif
+
+namespace freud {
+
+/// The differences between two versions of a context's mapped regions
+struct RegionChanges {
+    RegionChanges() : unchanged(0) {}
+
+    /// The regions that are new (or whose bounds, permissions or mapping
+    /// changed), in address order
+    std::vector<AddressRange> added;
+
+    /// The regions that are no longer mapped (or that changed), in
+    /// address order
+    std::vector<AddressRange> removed;
+
+    /// The number of regions that are exactly as they were
+    std::size_t unchanged;
+
+    /// True if nothing changed
+    bool empty() const { return added.empty() && removed.empty(); }
+};
+
+namespace detail {
+
+inline long atomic_increment(volatile long* value) {
+#if defined _MSC_VER
+    return InterlockedIncrement(value);
+#else
+    return __sync_add_and_fetch(value, 1);
+#endif
+}
+
+inline long atomic_decrement(volatile long* value) {
+#if defined _MSC_VER
+    return InterlockedDecrement(value);
+#else
+    return __sync_sub_and_fetch(value, 1);
+#endif
+}
+
+/// A lock for critical sections of a few instructions, such as copying a
+/// RegionTableRef while another thread replaces it
+class SpinLock {
+public:
+    SpinLock() : m_locked(0) {}
+
+    void lock() {
+#if defined _MSC_VER
+        while (InterlockedExchange(&m_locked, 1) != 0) {
+            YieldProcessor();
+        }
+#else
+        while (__sync_lock_test_and_set(&m_locked, 1) != 0) {
+            while (m_locked != 0) {
+            }
+        }
+#endif
+    }
+
+    void unlock() {
+#if defined _MSC_VER
+        InterlockedExchange(&m_locked, 0);
+#else
+        __sync_lock_release(&m_locked);
+#endif
+    }
+
+private:
+    SpinLock(const SpinLock&);
+    SpinLock& operator=(const SpinLock&);
+
+    volatile long m_locked;
+};
+
+/// Holds a SpinLock for the lifetime of the SpinLockGuard
+class SpinLockGuard {
+public:
+    explicit SpinLockGuard(SpinLock& lock) : m_lock(lock) { m_lock.lock(); }
+    ~SpinLockGuard() { m_lock.unlock(); }
+
+private:
+    SpinLockGuard(const SpinLockGuard&);
+    SpinLockGuard& operator=(const SpinLockGuard&);
+
+    SpinLock& m_lock;
+};
+
+/** \brief One version of a context's mapped regions
+ *
+ * A RegionTable never changes once it has been built. When a context
+ * updates its regions, it builds a new table with the next version number
+ * and replaces its reference to the old one, so iterators holding a
+ * reference to the old table can keep using it. A table is deleted when
+ * its last reference (see RegionTableRef) is released.
+ */
+template <typename Region>
+class RegionTable {
+public:
+    typedef typename std::vector<Region>::const_iterator const_iterator;
+
+    /// Take the contents of 'regions', which must be sorted by address
+    RegionTable(std::vector<Region>& regions, unsigned long version)
+        : m_version(version), m_references(0) {
+        m_regions.swap(regions);
+        index();
+    }
+
+    const std::vector<Region>& regions() const { return m_regions; }
+
+    /// The version of the context's regions that this table holds
+    unsigned long version() const { return m_version; }
+
+    /// The region containing 'address', or the end of regions()
+    const_iterator region_containing(address_t address) const {
+        // The regions are sorted and do not overlap, so only the last
+        // region starting at or before 'address' can contain it
+        std::vector<address_t>::const_iterator start = std::upper_bound(
+            m_region_starts.begin(), m_region_starts.end(), address);
+        if (start == m_region_starts.begin()) {
+            return m_regions.end();
+        }
+        const_iterator iter =
+            m_regions.begin() + (start - m_region_starts.begin() - 1);
+        if (address < iter->end_address) {
+            return iter;
+        }
+        return m_regions.end();
+    }
+
+    /// The first region that ends after 'address', or the end of regions()
+    const_iterator region_after(address_t address) const {
+        const_iterator iter = region_containing(address);
+        if (iter != m_regions.end()) {
+            return iter;
+        }
+        std::vector<address_t>::const_iterator start = std::upper_bound(
+            m_region_starts.begin(), m_region_starts.end(), address);
+        return m_regions.begin() + (start - m_region_starts.begin());
+    }
+
+    /// Test whether an address is in the heap or an anonymous mapping
+    bool in_heap_or_anonymous(address_t address) const {
+        std::vector<AddressRange>::const_iterator iter = std::upper_bound(
+            m_heap_ranges.begin(), m_heap_ranges.end(), address,
+            &range_starts_after);
+        if (iter == m_heap_ranges.begin()) {
+            return false;
+        }
+        return address < (--iter)->end_address;
+    }
+
+    /// Find the differences between this table and 'newer'
+    void diff(const std::vector<Region>& newer, RegionChanges& changes) const {
+        changes = RegionChanges();
+        std::size_t i = 0;
+        std::size_t j = 0;
+        while (i < m_regions.size() || j < newer.size()) {
+            if (i < m_regions.size() && j < newer.size() &&
+                same_region(m_regions[i], newer[j])) {
+                ++changes.unchanged;
+                ++i;
+                ++j;
+            } else if (j == newer.size() ||
+                       (i < m_regions.size() &&
+                        m_regions[i].start_address <=
+                            newer[j].start_address)) {
+                AddressRange range = {m_regions[i].start_address,
+                                      m_regions[i].end_address};
+                changes.removed.push_back(range);
+                ++i;
+            } else {
+                AddressRange range = {newer[j].start_address,
+                                      newer[j].end_address};
+                changes.added.push_back(range);
+                ++j;
+            }
+        }
+    }
+
+    void acquire() const { atomic_increment(&m_references); }
+
+    /// Release a reference, deleting the table if it was the last one
+    void release() const {
+        if (atomic_decrement(&m_references) == 0) {
+            delete this;
+        }
+    }
+
+private:
+    RegionTable(const RegionTable&);
+    RegionTable& operator=(const RegionTable&);
+
+    static bool same_region(const Region& a, const Region& b) {
+        return a.start_address == b.start_address &&
+               a.end_address == b.end_address &&
+               a.permissions == b.permissions && a.offset == b.offset &&
+               a.inode == b.inode && a.name == b.name;
+    }
+
+    static bool range_starts_after(address_t address,
+                                   const AddressRange& range) {
+        return address < range.start_address;
+    }
+
+    /// Build the lookup tables used by region_containing and
+    /// in_heap_or_anonymous
+    void index() {
+        m_region_starts.reserve(m_regions.size());
+        for (std::size_t i = 0; i < m_regions.size(); ++i) {
+            const Region& region = m_regions[i];
+            m_region_starts.push_back(region.start_address);
+
+            // Anonymous guard pages and read-only mappings cannot hold
+            // dynamically created objects
+            if (region.name != "[heap]" &&
+                (!region.name.empty() ||
+                 !(region.permissions & REGION_WRITE))) {
+                continue;
+            }
+            if (!m_heap_ranges.empty() &&
+                m_heap_ranges.back().end_address == region.start_address) {
+                m_heap_ranges.back().end_address = region.end_address;
+            } else {
+                AddressRange range = {region.start_address,
+                                      region.end_address};
+                m_heap_ranges.push_back(range);
+            }
+        }
+    }
+
+    std::vector<Region> m_regions;
+
+    // The start address of each region in m_regions, kept separately so
+    // lookups only touch a compact array
+    std::vector<address_t> m_region_starts;
+
+    // The merged address ranges of the heap and anonymous regions
+    std::vector<AddressRange> m_heap_ranges;
+
+    unsigned long m_version;
+    mutable volatile long m_references;
+};
+
+/// A counted reference to a RegionTable, which may be copied freely (and
+/// by several threads at once)
+template <typename Region>
+class RegionTableRef {
+public:
+    RegionTableRef() : m_table(NULL) {}
+
+    explicit RegionTableRef(const RegionTable<Region>* table)
+        : m_table(table) {
+        if (m_table) {
+            m_table->acquire();
+        }
+    }
+
+    RegionTableRef(const RegionTableRef& other) : m_table(other.m_table) {
+        if (m_table) {
+            m_table->acquire();
+        }
+    }
+
+    ~RegionTableRef() {
+        if (m_table) {
+            m_table->release();
+        }
+    }
+
+    RegionTableRef& operator=(const RegionTableRef& other) {
+        RegionTableRef copy(other);
+        std::swap(m_table, copy.m_table);
+        return *this;
+    }
+
+    void swap(RegionTableRef& other) { std::swap(m_table, other.m_table); }
+
+    const RegionTable<Region>* get() const { return m_table; }
+    const RegionTable<Region>* operator->() const { return m_table; }
+    const RegionTable<Region>& operator*() const { return *m_table; }
+
+private:
+    const RegionTable<Region>* m_table;
+};
+}
+}
+
+#endif
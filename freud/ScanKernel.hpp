@@ -0,0 +1,277 @@
+#ifndef FREUD_SCAN_KERNEL
+#define FREUD_SCAN_KERNEL
+
+#include "freud/AlignedBuffer.hpp"
+#include "freud/Alignment.hpp"
+#include "freud/BatchVerify.hpp"
+#include "freud/Defines.hpp"
+#include "freud/Prefilter.hpp"
+#include "freud/ScanStats.hpp"
+#include <cstddef>
+#include <cstring>
+
+namespace freud {
+namespace detail {
+
+/// Verify a candidate object, passing it to 'sink' if it matches
+/**
+ * \returns false if the sink asked for the scan to stop
+ */
+template <typename MemObject, typename Context, typename Sink>
+bool check_object(const Context& ctx, const byte_t* data, address_t base,
+                  std::size_t offset, Sink& sink, ScanCounters* counters) {
+    typedef typename MemObject::type type;
+    const byte_t* bytes = data + offset;
+    ObjectStorage<type> aligned;
+    if (reinterpret_cast<address_t>(bytes) % alignment_of<type>::value != 0) {
+        std::memcpy(aligned.bytes, bytes, sizeof(type));
+        bytes = aligned.bytes;
+    }
+    const type& object = *reinterpret_cast<const type*>(bytes);
+
+    FREUD_STAT(if (counters) { ++counters->verify_calls; });
+    MemObject::before_check();
+    if (MemObject::verify(ctx, object, base + offset)) {
+        return sink(base + offset, object);
+    }
+    return true;
+}
+
+/// Pass an object that has already been verified to 'sink'
+template <typename MemObject, typename Sink>
+bool deliver_object(const byte_t* data, address_t base, std::size_t offset,
+                    Sink& sink) {
+    typedef typename MemObject::type type;
+    const byte_t* bytes = data + offset;
+    ObjectStorage<type> aligned;
+    if (reinterpret_cast<address_t>(bytes) % alignment_of<type>::value != 0) {
+        std::memcpy(aligned.bytes, bytes, sizeof(type));
+        bytes = aligned.bytes;
+    }
+    return sink(base + offset, *reinterpret_cast<const type*>(bytes));
+}
+
+/** \brief Verifies the candidates found by a ScanKernel
+ *
+ * Candidates are passed to `add` in increasing order of offset, and
+ * `flush` is called once there are no more. Both return false once the
+ * sink has asked for the scan to stop, after which `stopped` is the offset
+ * of the match that stopped it.
+ *
+ * This version verifies each candidate as soon as it is added. If the
+ * MemObject has a verify_batch hook, the specialization below is used
+ * instead.
+ */
+template <typename MemObject, typename Context, typename Sink,
+          bool Batched = has_verify_batch<MemObject, Context>::value>
+class CandidateChecker {
+public:
+    CandidateChecker(const Context& ctx, const byte_t* data, address_t base,
+                     Sink& sink, ScanCounters* counters)
+        : m_ctx(ctx), m_data(data), m_base(base), m_sink(sink),
+          m_counters(counters), m_stopped(0) {}
+
+    bool add(std::size_t offset) {
+        if (!check_object<MemObject>(m_ctx, m_data, m_base, offset, m_sink,
+                                     m_counters)) {
+            m_stopped = offset;
+            return false;
+        }
+        return true;
+    }
+
+    bool flush() { return true; }
+
+    std::size_t stopped() const { return m_stopped; }
+
+private:
+    const Context& m_ctx;
+    const byte_t* m_data;
+    address_t m_base;
+    Sink& m_sink;
+    ScanCounters* m_counters;
+    std::size_t m_stopped;
+};
+
+/// Collects up to verify_batch_size candidates at a time, and verifies
+/// them with a single call to MemObject::verify_batch
+template <typename MemObject, typename Context, typename Sink>
+class CandidateChecker<MemObject, Context, Sink, true> {
+public:
+    CandidateChecker(const Context& ctx, const byte_t* data, address_t base,
+                     Sink& sink, ScanCounters* counters)
+        : m_ctx(ctx), m_data(data), m_base(base), m_sink(sink),
+          m_counters(counters), m_count(0), m_stopped(0) {}
+
+    bool add(std::size_t offset) {
+        m_offsets[m_count++] = offset;
+        return m_count < verify_batch_size || flush();
+    }
+
+    bool flush() {
+        if (m_count == 0) {
+            return true;
+        }
+        FREUD_STAT(if (m_counters) { m_counters->verify_calls += m_count; });
+        MemObject::before_check();
+        uint64_t matches = MemObject::verify_batch(m_ctx, m_data, m_base,
+                                                   m_offsets, m_count);
+        if (m_count < verify_batch_size) {
+            matches &= (uint64_t(1) << m_count) - 1;
+        }
+        m_count = 0;
+
+        while (matches != 0) {
+            const std::size_t offset = m_offsets[lowest_bit(matches)];
+            matches &= matches - 1;
+            if (!deliver_object<MemObject>(m_data, m_base, offset, m_sink)) {
+                m_stopped = offset;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::size_t stopped() const { return m_stopped; }
+
+private:
+    const Context& m_ctx;
+    const byte_t* m_data;
+    address_t m_base;
+    Sink& m_sink;
+    ScanCounters* m_counters;
+
+    std::size_t m_offsets[verify_batch_size];
+    std::size_t m_count;
+    std::size_t m_stopped;
+};
+
+/** \brief Applies a MemObject's checks to a buffer of target memory
+ *
+ * 'data' holds 'size' bytes copied from the target, starting at the
+ * target address 'base'. Every object that begins at an offset in
+ * [begin, end) and lies entirely within the buffer is checked with
+ * MemObject::verify, and each match is passed to 'sink' as
+ * `sink(address, object)`. The sink returns false to stop the scan.
+ *
+ * 'begin' must be a multiple of the object's alignment relative to the
+ * start of the region. If 'data' is not suitably aligned for the type,
+ * each candidate is copied to aligned storage before being verified.
+ *
+ * `scan` returns the offset at which a later scan should resume: just past
+ * the match that stopped the scan, or the first aligned offset at or after
+ * 'end' if the sink never stopped it.
+ *
+ * If the MemObject declares anchors, only offsets at which the anchors
+ * hold are passed to verify. When possible, those offsets are located
+ * with a vectorized search for one of the anchor bytes.
+ *
+ * If the MemObject has a verify_batch hook (see has_verify_batch), the
+ * candidate offsets are collected and verified in batches instead.
+ *
+ * If 'counters' is given, its verify_calls are incremented for every
+ * candidate verified.
+ */
+template <typename MemObject>
+struct ScanKernel {
+    typedef typename MemObject::type type;
+
+    static const std::size_t alignment = alignment_of<type>::value;
+
+    template <typename Context, typename Sink>
+    static std::size_t scan(const Context& ctx, const byte_t* data,
+                            std::size_t size, address_t base,
+                            std::size_t begin, std::size_t end, Sink& sink,
+                            ScanCounters* counters = NULL) {
+        if (size < sizeof(type)) {
+            return resume_offset(begin, end);
+        }
+        std::size_t last = end;
+        if (last > size - sizeof(type) + 1) {
+            last = size - sizeof(type) + 1;
+        }
+
+        const Prefilter<MemObject>& prefilter =
+            Prefilter<MemObject>::instance();
+        CandidateChecker<MemObject, Context, Sink> checker(ctx, data, base,
+                                                           sink, counters);
+        bool finished;
+        if (prefilter.has_probe()) {
+            finished = scan_probed(data, begin, last, prefilter, checker);
+        } else {
+            finished = true;
+            for (std::size_t offset = begin; finished && offset < last;
+                 offset += alignment) {
+                if (prefilter.empty() || prefilter.matches(data + offset)) {
+                    finished = checker.add(offset);
+                }
+            }
+        }
+        if (!finished || !checker.flush()) {
+            return checker.stopped() + alignment;
+        }
+        return resume_offset(begin, end);
+    }
+
+    /// Check only the objects at the given offsets into 'data'
+    /**
+     * The offsets must be in increasing order, and each object must lie
+     * entirely within the buffer. The anchors are applied as by `scan`.
+     * The sink should always return true, as the scan cannot be resumed.
+     */
+    template <typename Context, typename Sink>
+    static void scan_offsets(const Context& ctx, const byte_t* data,
+                             address_t base, const std::size_t* offsets,
+                             std::size_t count, Sink& sink,
+                             ScanCounters* counters = NULL) {
+        const Prefilter<MemObject>& prefilter =
+            Prefilter<MemObject>::instance();
+        CandidateChecker<MemObject, Context, Sink> checker(ctx, data, base,
+                                                           sink, counters);
+        for (std::size_t i = 0; i < count; ++i) {
+            if ((prefilter.empty() || prefilter.matches(data + offsets[i])) &&
+                !checker.add(offsets[i])) {
+                return;
+            }
+        }
+        checker.flush();
+    }
+
+private:
+    static std::size_t resume_offset(std::size_t begin, std::size_t end) {
+        if (end <= begin) {
+            return begin;
+        }
+        return begin + (end - begin + alignment - 1) / alignment * alignment;
+    }
+
+    /// Pass the offsets whose probe byte and anchors match to 'checker',
+    /// returning false if the sink asked for the scan to stop
+    template <typename Checker>
+    static bool scan_probed(const byte_t* data, std::size_t begin,
+                            std::size_t last,
+                            const Prefilter<MemObject>& prefilter,
+                            Checker& checker) {
+        const std::size_t probe = prefilter.probe_offset();
+        const std::size_t stride = alignment <= 64 ? alignment : 1;
+        const std::size_t phase = (begin + probe) & (stride - 1);
+
+        std::size_t position = begin + probe;
+        const std::size_t stop = last + probe;
+        while ((position = find_byte(data, position, stop,
+                                     prefilter.probe_value(), stride,
+                                     phase)) < stop) {
+            const std::size_t offset = position - probe;
+            if ((offset - begin) % alignment == 0 &&
+                prefilter.matches(data + offset) && !checker.add(offset)) {
+                return false;
+            }
+            position += stride;
+        }
+        return true;
+    }
+};
+}
+}
+
+#endif
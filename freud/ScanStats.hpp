@@ -0,0 +1,189 @@
+#ifndef FREUD_SCAN_STATS
+#define FREUD_SCAN_STATS
+
+#include "freud/Defines.hpp"
+#include <stdint.h>
+#include <vector>
+
+#if defined _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/*
+ * Scans keep counters of the work they do (see ScanStats). They are cheap,
+ * but they can be removed entirely by defining FREUD_DISABLE_STATS before
+ * including any freud header, in which case every counter reads as zero.
+ * The disabled statements are still compiled (and then discarded), so
+ * they cannot cause unused variable warnings.
+ */
+#if defined FREUD_DISABLE_STATS
+#define FREUD_STAT(statement)                                                  \
+    do {                                                                       \
+        if (false) {                                                           \
+            statement;                                                         \
+        }                                                                      \
+    } while (0)
+#else
+#define FREUD_STAT(statement)                                                  \
+    do {                                                                       \
+        statement;                                                             \
+    } while (0)
+#endif
+
+namespace freud {
+
+/// Counters describing the work done by (part of) a scan
+struct ScanCounters {
+    /// The number of bytes the scan asked to read from the target
+    uint64_t bytes_requested;
+
+    /// The number of those bytes that could actually be read
+    uint64_t bytes_read;
+
+    /// The number of system calls used to read them
+    uint64_t read_calls;
+
+    /// The number of reads that could not be completed
+    uint64_t failed_reads;
+
+    /// The number of times MemObject::verify was called
+    uint64_t verify_calls;
+
+    /// The number of objects that were found
+    uint64_t matches;
+
+    /// The time spent scanning, in seconds. For a parallel scan, this is
+    /// the sum of the time spent by every thread.
+    double seconds;
+
+    ScanCounters()
+        : bytes_requested(0), bytes_read(0), read_calls(0), failed_reads(0),
+          verify_calls(0), matches(0), seconds(0) {}
+
+    void add(const ScanCounters& other) {
+        bytes_requested += other.bytes_requested;
+        bytes_read += other.bytes_read;
+        read_calls += other.read_calls;
+        failed_reads += other.failed_reads;
+        verify_calls += other.verify_calls;
+        matches += other.matches;
+        seconds += other.seconds;
+    }
+};
+
+/// The counters of a scan for a single region
+struct RegionStats : public ScanCounters {
+    address_t start_address;
+    address_t end_address;
+
+    /// True if part of the region was skipped because it could not be read
+    bool skipped;
+
+    RegionStats() : start_address(0), end_address(0), skipped(false) {}
+};
+
+/** \brief The statistics of a scan
+ *
+ * The totals are always collected. The per-region breakdown in 'regions'
+ * is only collected when requested (see
+ * BaseMemoryContext::set_region_stats), and lists the regions in the
+ * order they were scanned.
+ */
+struct ScanStats : public ScanCounters {
+    /// The number of regions that were partly or entirely skipped because
+    /// they could not be read
+    uint64_t regions_skipped;
+
+    /// The time from the start of the scan until its end, in seconds
+    double wall_seconds;
+
+    std::vector<RegionStats> regions;
+
+    ScanStats() : regions_skipped(0), wall_seconds(0) {}
+};
+
+namespace detail {
+
+/// A monotonic clock, in seconds
+inline double stats_clock() {
+#if defined _WIN32
+    LARGE_INTEGER count;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return double(count.QuadPart) / frequency.QuadPart;
+#else
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+/// A counter that may be incremented by several threads at once
+class StatCounter {
+public:
+    StatCounter() : m_value(0) {}
+
+    void add(uint64_t value) {
+#if defined _MSC_VER
+        FREUD_STAT(InterlockedExchangeAdd64(
+            reinterpret_cast<volatile LONGLONG*>(&m_value), value));
+#else
+        FREUD_STAT(__sync_fetch_and_add(&m_value, value));
+#endif
+    }
+
+    uint64_t value() const { return m_value; }
+
+    void reset() { m_value = 0; }
+
+private:
+    volatile uint64_t m_value;
+};
+
+/// The read counters of a context, which may be updated by several
+/// threads at once
+struct SharedReadCounters {
+    StatCounter bytes_requested;
+    StatCounter bytes_read;
+    StatCounter read_calls;
+    StatCounter failed_reads;
+
+    void add(const ScanCounters& counters) {
+        bytes_requested.add(counters.bytes_requested);
+        bytes_read.add(counters.bytes_read);
+        read_calls.add(counters.read_calls);
+        failed_reads.add(counters.failed_reads);
+    }
+
+    ScanCounters get() const {
+        ScanCounters counters;
+        counters.bytes_requested = bytes_requested.value();
+        counters.bytes_read = bytes_read.value();
+        counters.read_calls = read_calls.value();
+        counters.failed_reads = failed_reads.value();
+        return counters;
+    }
+
+    void reset() {
+        bytes_requested.reset();
+        bytes_read.reset();
+        read_calls.reset();
+        failed_reads.reset();
+    }
+};
+
+/// Add the read counters in 'after' that are not in 'before' to 'counters'
+inline void add_read_delta(ScanCounters& counters, const ScanCounters& before,
+                           const ScanCounters& after) {
+    counters.bytes_requested += after.bytes_requested - before.bytes_requested;
+    counters.bytes_read += after.bytes_read - before.bytes_read;
+    counters.read_calls += after.read_calls - before.read_calls;
+    counters.failed_reads += after.failed_reads - before.failed_reads;
+}
+}
+}
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef FREUD_SNAPSHOT
+#define FREUD_SNAPSHOT
+
+#include "freud/AlignedBuffer.hpp"
+#include "freud/Defines.hpp"
+#include "freud/LinuxReadBackend.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace freud {
+namespace detail {
+
+/** \brief The layout of a snapshot file
+ *
+ * A snapshot starts with a SnapshotHeader, followed by 'region_count'
+ * SnapshotRegionEntry structures and then the names of the regions. The
+ * bytes of each region start at its 'data_offset', which is a multiple of
+ * the page size. Pages that were entirely zero (or could not be read) are
+ * not written, so on file systems that support sparse files they occupy no
+ * space. All fields are stored in the byte order of the machine that
+ * created the snapshot.
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t page_size;
+    uint64_t region_count;
+    uint64_t names_offset;
+    uint64_t names_size;
+};
+
+struct SnapshotRegionEntry {
+    uint64_t start_address;
+    uint64_t end_address;
+    uint64_t data_offset;
+    uint64_t file_offset;
+    uint64_t inode;
+    uint64_t name_offset;
+    uint32_t name_length;
+    uint32_t permissions;
+};
+
+const char snapshot_magic[8] = {'F', 'R', 'E', 'U', 'D', 'S', 'N', 'P'};
+const uint32_t snapshot_version = 1;
+
+/// The number of bytes read from the target at once while writing
+const std::size_t snapshot_chunk_size = 4 * 1024 * 1024;
+
+inline bool write_all(int fd, const void* data, std::size_t size,
+                      uint64_t offset) {
+    const byte_t* bytes = static_cast<const byte_t*>(data);
+    while (size > 0) {
+        ssize_t result = pwrite(fd, bytes, size, offset);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result <= 0) {
+            return false;
+        }
+        bytes += result;
+        size -= result;
+        offset += result;
+    }
+    return true;
+}
+
+inline bool is_zero(const byte_t* data, std::size_t size) {
+    const uint64_t* words = reinterpret_cast<const uint64_t*>(data);
+    for (std::size_t i = 0; i < size / sizeof(uint64_t); ++i) {
+        if (words[i] != 0) {
+            return false;
+        }
+    }
+    for (std::size_t i = size - size % sizeof(uint64_t); i < size; ++i) {
+        if (data[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Write the pages of 'data' that are not entirely zero at 'offset'
+inline bool write_sparse(int fd, const byte_t* data, std::size_t size,
+                         uint64_t offset, std::size_t page) {
+    std::size_t run_start = 0;
+    bool in_run = false;
+    for (std::size_t i = 0; i < size; i += page) {
+        std::size_t length = size - i < page ? size - i : page;
+        bool zero = is_zero(data + i, length);
+        if (!zero && !in_run) {
+            run_start = i;
+            in_run = true;
+        } else if (zero && in_run) {
+            if (!write_all(fd, data + run_start, i - run_start,
+                           offset + run_start)) {
+                return false;
+            }
+            in_run = false;
+        }
+    }
+    return !in_run ||
+           write_all(fd, data + run_start, size - run_start,
+                     offset + run_start);
+}
+}
+
+/** \brief Save the regions of a context to a snapshot file
+ *
+ * Every region in `ctx.mapped_regions()` is read (with `ctx.read_batch`)
+ * and written to 'path', which can then be opened with a
+ * SnapshotMemoryContext. Pages that cannot be read are stored as zeros.
+ * Use a RegionFilter when creating the context to control which regions
+ * are saved.
+ *
+ * \returns false if the file could not be written
+ */
+template <typename Context>
+bool write_snapshot(Context& ctx, const std::string& path) {
+    typedef typename Context::MemoryRegion MemoryRegion;
+    const std::vector<MemoryRegion>& regions = ctx.mapped_regions();
+    const std::size_t page = detail::page_size();
+
+    detail::SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, detail::snapshot_magic, sizeof(header.magic));
+    header.version = detail::snapshot_version;
+    header.page_size = page;
+    header.region_count = regions.size();
+    header.names_offset =
+        sizeof(header) + regions.size() * sizeof(detail::SnapshotRegionEntry);
+
+    std::string names;
+    std::vector<detail::SnapshotRegionEntry> entries(regions.size());
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        entries[i].start_address = regions[i].start_address;
+        entries[i].end_address = regions[i].end_address;
+        entries[i].file_offset = regions[i].offset;
+        entries[i].inode = regions[i].inode;
+        entries[i].name_offset = names.size();
+        entries[i].name_length = regions[i].name.size();
+        entries[i].permissions = regions[i].permissions;
+        names += regions[i].name;
+    }
+    header.names_size = names.size();
+
+    uint64_t data_offset = header.names_offset + names.size();
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        data_offset = (data_offset + page - 1) / page * page;
+        entries[i].data_offset = data_offset;
+        data_offset += entries[i].end_address - entries[i].start_address;
+    }
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        return false;
+    }
+    bool result =
+        detail::write_all(fd, &header, sizeof(header), 0) &&
+        (entries.empty() ||
+         detail::write_all(fd, &entries[0],
+                           entries.size() * sizeof(entries[0]),
+                           sizeof(header))) &&
+        detail::write_all(fd, names.data(), names.size(),
+                          header.names_offset);
+
+    detail::AlignedBuffer buffer;
+    std::vector<ReadRequest> requests(1);
+    for (std::size_t i = 0; result && i < entries.size(); ++i) {
+        for (address_t address = entries[i].start_address;
+             result && address < entries[i].end_address;) {
+            std::size_t size = entries[i].end_address - address;
+            if (size > detail::snapshot_chunk_size) {
+                size = detail::snapshot_chunk_size;
+            }
+            buffer.resize(size);
+            ReadRequest request = {address, buffer.data(), size, 0};
+            requests[0] = request;
+            ctx.read_batch(requests);
+            if (requests[0].bytes_read < size) {
+                std::memset(buffer.data() + requests[0].bytes_read, 0,
+                            size - requests[0].bytes_read);
+            }
+            result = detail::write_sparse(
+                fd, buffer.data(), size,
+                entries[i].data_offset + (address - entries[i].start_address),
+                page);
+            address += size;
+        }
+    }
+
+    // Extend the file over any trailing zero pages
+    result = result && ftruncate(fd, data_offset) == 0;
+    return close(fd) == 0 && result;
+}
+}
+
+#endif
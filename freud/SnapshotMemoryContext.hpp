@@ -0,0 +1,673 @@
+#ifndef FREUD_SNAPSHOT_MEMORY_CONTEXT
+#define FREUD_SNAPSHOT_MEMORY_CONTEXT
+
+#include "freud/MemoryContext.hpp"
+#include "freud/ParallelScan.hpp"
+#include "freud/ProcessPause.hpp"
+#include "freud/RegionFilter.hpp"
+#include "freud/Snapshot.hpp"
+#include <algorithm>
+#include <cstring>
+#include <elf.h>
+#include <fcntl.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace freud {
+
+/// The default limit on the time a live target is stopped for while a
+/// SnapshotMemoryContext copies its memory
+const double default_max_pause_seconds = 0.02;
+
+/// Statistics describing how a SnapshotMemoryContext was copied from a live
+/// process
+struct CaptureStats {
+    CaptureStats()
+        : pause_seconds(0), longest_pause_seconds(0), pauses(0),
+          consistent(false), bytes_copied(0), bytes_failed(0) {}
+
+    /// The total time for which the target was stopped
+    double pause_seconds;
+
+    /// The time for which the target was stopped at once, at most
+    double longest_pause_seconds;
+
+    /// The number of times the target was stopped
+    std::size_t pauses;
+
+    /// True if every region was copied while the target was stopped once,
+    /// so the snapshot shows the target at a single moment
+    bool consistent;
+
+    /// The number of bytes copied from the target
+    std::size_t bytes_copied;
+
+    /// The number of bytes that could not be read (stored as zeros)
+    std::size_t bytes_failed;
+};
+
+namespace detail {
+
+/// The number of bytes copied with one `read_batch` while capturing a
+/// live process. The pause budget is checked between batches.
+const std::size_t capture_batch_size = 4 * 1024 * 1024;
+}
+
+/** \brief A MemoryContext for a saved copy of a process's memory
+ *
+ * A SnapshotMemoryContext maps a file created by `write_snapshot`, or an
+ * ELF core file (such as one created by gdb's `gcore`), into memory. The
+ * bytes of the regions are used where they lie in the mapping, so `view`
+ * and scans do not copy them, and the file is only read as pages are
+ * touched.
+ *
+ * The regions of a snapshot never change, so any number of iterators (and
+ * `scan_parallel`) may use the context at the same time, and every scan
+ * sees the same bytes.
+ *
+ * Core files must be 64 bit and have the byte order of this machine. Only
+ * the PT_LOAD segments with contents in the file become regions. They are
+ * named from the core's NT_FILE note (if present).
+ *
+ * A snapshot can also be copied into memory from a running process, giving
+ * a consistent view of structures that are being modified while the
+ * target runs (see the LinuxMemoryContext constructor).
+ */
+class SnapshotMemoryContext : public BaseMemoryContext<SnapshotMemoryContext> {
+public:
+    /// Open a snapshot or core file, keeping the regions accepted by
+    /// 'filter'. Use is_open to test whether the file could be read.
+    explicit SnapshotMemoryContext(const std::string& path,
+                                   const RegionFilter& filter = RegionFilter())
+        : BaseMemoryContext(), m_map(NULL), m_map_size(0) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat info;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            void* map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map != MAP_FAILED) {
+                m_map = static_cast<const byte_t*>(map);
+                m_map_size = info.st_size;
+            }
+        }
+        close(fd);
+
+        if (m_map && !load_snapshot(filter) && !load_core(filter)) {
+            munmap(const_cast<byte_t*>(m_map), m_map_size);
+            m_map = NULL;
+            m_map_size = 0;
+        }
+        sort_regions();
+    }
+
+    /// Copy the regions of a running process into memory
+    /**
+     * Every thread of the target is stopped (with PTRACE_SEIZE and
+     * PTRACE_INTERRUPT), `ctx.mapped_regions()` are copied into buffers
+     * that were allocated and populated beforehand, using large batched
+     * reads, and the target is resumed. The snapshot is then scanned
+     * without affecting the target.
+     *
+     * If copying takes longer than 'max_pause_seconds' (0 means there is
+     * no limit), the target is resumed, and each remaining region is
+     * copied while the target is stopped separately. Each region is then
+     * consistent in itself, but different regions may have been copied at
+     * different times. A region that takes longer than the limit to copy
+     * still stops the target for as long as it takes. If the target cannot
+     * be stopped at all (for example, because it is already being traced),
+     * the regions are copied while it runs.
+     *
+     * If 'stats' is given, it receives the time for which the target was
+     * stopped and whether the snapshot is consistent.
+     */
+    explicit SnapshotMemoryContext(
+        LinuxMemoryContext& ctx,
+        double max_pause_seconds = default_max_pause_seconds,
+        CaptureStats* stats = NULL)
+        : BaseMemoryContext(), m_map(NULL), m_map_size(0) {
+        CaptureStats result;
+        capture(ctx, max_pause_seconds, result);
+        if (stats) {
+            *stats = result;
+        }
+        sort_regions();
+    }
+
+    ~SnapshotMemoryContext() {
+        if (m_map) {
+            munmap(const_cast<byte_t*>(m_map), m_map_size);
+        }
+    }
+
+    /// True if the file was a valid snapshot or core file (or the process
+    /// could be copied)
+    bool is_open() const { return m_map != NULL; }
+
+    bool read(address_t address, std::vector<char>& buffer) const {
+        return read(address, buffer, region_containing(address));
+    }
+
+    bool
+    read(address_t address, std::vector<char>& buffer,
+         std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter)
+        const {
+        if (iter == mapped_regions().end() || buffer.empty() ||
+            buffer.size() > iter->end_address - address) {
+            return false;
+        }
+        std::memcpy(&buffer[0], region_data(iter) +
+                                    (address - iter->start_address),
+                    buffer.size());
+        return true;
+    }
+
+    /// Read a T from 'address'
+    /**
+     * If the bytes are not in the snapshot, '*ok' (if given) is set to
+     * false and an object whose bytes are all zero is returned.
+     */
+    template <typename T>
+    T read(address_t address, bool* ok = NULL) const {
+        detail::ObjectStorage<T> storage;
+        const byte_t* bytes = data(address, sizeof(T));
+        if (bytes) {
+            std::memcpy(storage.bytes, bytes, sizeof(T));
+        } else {
+            std::memset(storage.bytes, 0, sizeof(T));
+        }
+        if (ok) {
+            *ok = bytes != NULL;
+        }
+        return storage.get();
+    }
+
+    /// Get a pointer to the bytes [address, address + size)
+    /**
+     * This does not copy anything. The pointer remains valid for the
+     * lifetime of the context.
+     *
+     * \returns NULL if the bytes do not lie within a single region
+     */
+    const byte_t* data(address_t address, std::size_t size) const {
+        std::vector<MemoryRegion>::const_iterator iter =
+            region_containing(address);
+        if (iter == mapped_regions().end() ||
+            size > iter->end_address - address) {
+            return NULL;
+        }
+        return region_data(iter) + (address - iter->start_address);
+    }
+
+    /// Get a pointer to the bytes from 'address' to the end of its region
+    /**
+     * 'data' points into the mapped file and 'available' is the number of
+     * bytes until the end of the region described by 'iter'. Bytes at
+     * aligned offsets from the start of the region are suitably aligned.
+     */
+    bool view(address_t address,
+              std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+              const byte_t*& data, std::size_t& available,
+              std::size_t = 1) const {
+        if (iter == mapped_regions().end() || address < iter->start_address ||
+            address >= iter->end_address) {
+            return false;
+        }
+        data = region_data(iter) + (address - iter->start_address);
+        available = iter->end_address - address;
+        return true;
+    }
+
+    /// Copy several (possibly discontiguous) ranges of the snapshot
+    /**
+     * This behaves like `LinuxMemoryContext::read_batch`. Bytes outside of
+     * the snapshot's regions are zero-filled and reported in 'failed'.
+     *
+     * \returns true if every request was read completely
+     */
+    bool read_batch(std::vector<ReadRequest>& requests,
+                    std::vector<FailedRange>* failed = NULL,
+                    ScanCounters* counters = NULL) const {
+        ScanCounters work;
+        bool result = true;
+        for (std::size_t i = 0; i < requests.size(); ++i) {
+            ReadRequest& request = requests[i];
+            request.bytes_read = 0;
+            while (request.bytes_read < request.size) {
+                address_t address = request.address + request.bytes_read;
+                std::size_t remaining = request.size - request.bytes_read;
+                std::vector<MemoryRegion>::const_iterator iter =
+                    region_containing(address);
+                if (iter == mapped_regions().end()) {
+                    break;
+                }
+                std::size_t length = iter->end_address - address;
+                if (length > remaining) {
+                    length = remaining;
+                }
+                std::memcpy(request.buffer + request.bytes_read,
+                            region_data(iter) +
+                                (address - iter->start_address),
+                            length);
+                request.bytes_read += length;
+            }
+            if (request.bytes_read < request.size) {
+                std::memset(request.buffer + request.bytes_read, 0,
+                            request.size - request.bytes_read);
+                if (failed) {
+                    FailedRange range = {request.address + request.bytes_read,
+                                         request.address + request.size};
+                    failed->push_back(range);
+                }
+                result = false;
+                FREUD_STAT(++work.failed_reads);
+            }
+            FREUD_STAT(work.bytes_requested += request.size);
+            FREUD_STAT(work.bytes_read += request.bytes_read);
+        }
+        FREUD_STAT(m_read_counters.add(work));
+        FREUD_STAT(if (counters) { counters->add(work); });
+        return result;
+    }
+
+    /// Scan the snapshot for MemObjects using several threads
+    /**
+     * This behaves like `LinuxMemoryContext::scan_parallel`, except that
+     * the regions are scanned where they lie in the mapped file.
+     *
+     * \returns The number of matches found
+     */
+    template <typename MemObject, typename Callback>
+    std::size_t
+    scan_parallel(unsigned threads, Callback callback, bool ordered = false,
+                  std::size_t chunk_size = default_parallel_chunk_size,
+                  ScanStats* stats = NULL) const {
+        detail::ParallelScan<MemObject, const SnapshotMemoryContext, Callback>
+            scan(*this, callback, ordered);
+        return scan.run(threads, chunk_size, stats);
+    }
+
+    /// The regions of a snapshot never change, so this does nothing
+    void update_regions() {}
+
+private:
+    SnapshotMemoryContext(const SnapshotMemoryContext&);
+    SnapshotMemoryContext& operator=(const SnapshotMemoryContext&);
+
+    const byte_t*
+    region_data(std::vector<MemoryRegion>::const_iterator iter) const {
+        return m_region_data[iter - mapped_regions().begin()];
+    }
+
+    /// Check that [offset, offset + size) lies within the mapped file
+    bool in_file(uint64_t offset, uint64_t size) const {
+        return offset <= m_map_size && size <= m_map_size - offset;
+    }
+
+    void add_region(const MemoryRegion& region, const byte_t* data,
+                    const RegionFilter& filter) {
+        if (region.end_address > region.start_address &&
+            filter.accepts(region)) {
+            m_loaded_regions.push_back(region);
+            m_region_data.push_back(data);
+        }
+    }
+
+    bool load_snapshot(const RegionFilter& filter) {
+        detail::SnapshotHeader header;
+        if (!in_file(0, sizeof(header))) {
+            return false;
+        }
+        std::memcpy(&header, m_map, sizeof(header));
+        if (std::memcmp(header.magic, detail::snapshot_magic,
+                        sizeof(header.magic)) != 0 ||
+            header.version != detail::snapshot_version ||
+            header.region_count >
+                m_map_size / sizeof(detail::SnapshotRegionEntry) ||
+            !in_file(sizeof(header),
+                     header.region_count *
+                         sizeof(detail::SnapshotRegionEntry)) ||
+            !in_file(header.names_offset, header.names_size)) {
+            return false;
+        }
+
+        const char* names =
+            reinterpret_cast<const char*>(m_map + header.names_offset);
+        for (uint64_t i = 0; i < header.region_count; ++i) {
+            detail::SnapshotRegionEntry entry;
+            std::memcpy(&entry,
+                        m_map + sizeof(header) +
+                            i * sizeof(detail::SnapshotRegionEntry),
+                        sizeof(entry));
+            if (entry.end_address < entry.start_address ||
+                !in_file(entry.data_offset,
+                         entry.end_address - entry.start_address) ||
+                entry.name_offset > header.names_size ||
+                entry.name_length > header.names_size - entry.name_offset) {
+                return false;
+            }
+            MemoryRegion region = {
+                std::string(names + entry.name_offset, entry.name_length),
+                entry.start_address,
+                entry.end_address,
+                entry.permissions,
+                entry.file_offset,
+                entry.inode};
+            add_region(region, m_map + entry.data_offset, filter);
+        }
+        return true;
+    }
+
+    /// A file mapping described by a core file's NT_FILE note
+    struct CoreFile {
+        address_t start_address;
+        address_t end_address;
+        address_t offset;
+        std::string name;
+    };
+
+    static bool file_starts_before(const CoreFile& file, address_t address) {
+        return file.start_address < address;
+    }
+
+    static std::size_t note_align(std::size_t size) { return (size + 3) & ~3; }
+
+    void read_core_files(const Elf64_Phdr& note,
+                         std::vector<CoreFile>& files) const {
+        if (!in_file(note.p_offset, note.p_filesz)) {
+            return;
+        }
+        const byte_t* p = m_map + note.p_offset;
+        const byte_t* end = p + note.p_filesz;
+        while (static_cast<std::size_t>(end - p) >= sizeof(Elf64_Nhdr)) {
+            Elf64_Nhdr header;
+            std::memcpy(&header, p, sizeof(header));
+            p += sizeof(header);
+            std::size_t name_size = note_align(header.n_namesz);
+            std::size_t desc_size = note_align(header.n_descsz);
+            if (name_size > static_cast<std::size_t>(end - p) ||
+                desc_size > static_cast<std::size_t>(end - p) - name_size) {
+                return;
+            }
+            const byte_t* desc = p + name_size;
+            p = desc + desc_size;
+            if (header.n_type != NT_FILE || header.n_descsz < 16) {
+                continue;
+            }
+
+            // count, page size, then (start, end, page offset) per file,
+            // followed by the file names
+            uint64_t count;
+            uint64_t page;
+            std::memcpy(&count, desc, 8);
+            std::memcpy(&page, desc + 8, 8);
+            if (count > (header.n_descsz - 16) / 24) {
+                return;
+            }
+            const char* name = reinterpret_cast<const char*>(desc) + 16 +
+                               count * 24;
+            const char* names_end =
+                reinterpret_cast<const char*>(desc) + header.n_descsz;
+            for (uint64_t i = 0; i < count && name < names_end; ++i) {
+                uint64_t range[3];
+                std::memcpy(range, desc + 16 + i * 24, sizeof(range));
+                std::size_t length = strnlen(name, names_end - name);
+                CoreFile file = {range[0], range[1], range[2] * page,
+                                 std::string(name, length)};
+                files.push_back(file);
+                name += length + 1;
+            }
+        }
+    }
+
+    bool load_core(const RegionFilter& filter) {
+        Elf64_Ehdr elf;
+        if (!in_file(0, sizeof(elf))) {
+            return false;
+        }
+        std::memcpy(&elf, m_map, sizeof(elf));
+        if (std::memcmp(elf.e_ident, ELFMAG, SELFMAG) != 0 ||
+            elf.e_ident[EI_CLASS] != ELFCLASS64 || elf.e_type != ET_CORE ||
+            elf.e_phentsize != sizeof(Elf64_Phdr) ||
+            !in_file(elf.e_phoff, uint64_t(elf.e_phnum) * sizeof(Elf64_Phdr))) {
+            return false;
+        }
+
+        std::vector<Elf64_Phdr> segments(elf.e_phnum);
+        std::vector<CoreFile> files;
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            std::memcpy(&segments[i],
+                        m_map + elf.e_phoff + i * sizeof(Elf64_Phdr),
+                        sizeof(Elf64_Phdr));
+            if (segments[i].p_type == PT_NOTE) {
+                read_core_files(segments[i], files);
+            }
+        }
+        std::sort(files.begin(), files.end(), &file_precedes);
+
+        for (std::size_t i = 0; i < segments.size(); ++i) {
+            const Elf64_Phdr& segment = segments[i];
+            if (segment.p_type != PT_LOAD || segment.p_filesz == 0 ||
+                !in_file(segment.p_offset, segment.p_filesz)) {
+                continue;
+            }
+            MemoryRegion region = {"", segment.p_vaddr,
+                                   segment.p_vaddr + segment.p_filesz, 0, 0,
+                                   0};
+            if (segment.p_flags & PF_R) {
+                region.permissions |= REGION_READ;
+            }
+            if (segment.p_flags & PF_W) {
+                region.permissions |= REGION_WRITE;
+            }
+            if (segment.p_flags & PF_X) {
+                region.permissions |= REGION_EXECUTE;
+            }
+
+            // Name the region after the file mapping containing it
+            std::vector<CoreFile>::const_iterator file =
+                std::upper_bound(files.begin(), files.end(),
+                                 region.start_address, &file_starts_after);
+            if (file != files.begin() &&
+                region.start_address < (--file)->end_address) {
+                region.name = file->name;
+                region.offset =
+                    file->offset + (region.start_address - file->start_address);
+            }
+            add_region(region, m_map + segment.p_offset, filter);
+        }
+        return true;
+    }
+
+    /// Stop the target, returning the time at which it was stopped (or 0
+    /// if it could not be)
+    static double stop(detail::ProcessPause& pause, unsigned long pid) {
+        const double started = detail::stats_clock();
+        return pause.stop(pid) ? started : 0;
+    }
+
+    static void resume(detail::ProcessPause& pause, double stopped,
+                       CaptureStats& stats) {
+        if (!pause.stopped()) {
+            return;
+        }
+        pause.resume();
+        const double seconds = detail::stats_clock() - stopped;
+        stats.pause_seconds += seconds;
+        stats.longest_pause_seconds =
+            std::max(stats.longest_pause_seconds, seconds);
+        ++stats.pauses;
+    }
+
+    /// Perform the requests [first, last) with one read_batch
+    static void copy_requests(LinuxMemoryContext& ctx,
+                             const std::vector<ReadRequest>& requests,
+                             std::size_t first, std::size_t last,
+                             CaptureStats& stats) {
+        std::vector<ReadRequest> batch(requests.begin() + first,
+                                       requests.begin() + last);
+        ctx.read_batch(batch);
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            stats.bytes_copied += batch[i].bytes_read;
+            stats.bytes_failed += batch[i].size - batch[i].bytes_read;
+        }
+    }
+
+    void capture(LinuxMemoryContext& ctx, double max_pause_seconds,
+                 CaptureStats& stats) {
+        ctx.update_regions();
+        const std::vector<LinuxMemoryContext::MemoryRegion>& regions =
+            ctx.mapped_regions();
+        const std::size_t page = detail::page_size();
+
+        // Allocate (and fault in) the buffers before stopping the target,
+        // so the copy does not have to
+        std::size_t size = 0;
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            size += regions[i].end_address - regions[i].start_address;
+            size = (size + page - 1) / page * page;
+        }
+        if (size == 0) {
+            return;
+        }
+        void* map = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+        if (map == MAP_FAILED) {
+            return;
+        }
+        m_map = static_cast<const byte_t*>(map);
+        m_map_size = size;
+
+        // Each region is copied by one or more requests, starting with
+        // requests[region_requests[i]]
+        std::vector<ReadRequest> requests;
+        std::vector<std::size_t> region_requests;
+        byte_t* data = static_cast<byte_t*>(map);
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            region_requests.push_back(requests.size());
+            for (address_t address = regions[i].start_address;
+                 address < regions[i].end_address;) {
+                std::size_t length = regions[i].end_address - address;
+                if (length > detail::capture_batch_size) {
+                    length = detail::capture_batch_size;
+                }
+                ReadRequest request = {
+                    address,
+                    data + (address - regions[i].start_address), length, 0};
+                requests.push_back(request);
+                address += length;
+            }
+
+            MemoryRegion region = {regions[i].name,
+                                   regions[i].start_address,
+                                   regions[i].end_address,
+                                   regions[i].permissions,
+                                   regions[i].offset,
+                                   regions[i].inode};
+            m_loaded_regions.push_back(region);
+            m_region_data.push_back(data);
+            data += (regions[i].end_address - regions[i].start_address +
+                     page - 1) / page * page;
+        }
+        region_requests.push_back(requests.size());
+
+        // Copy as much as possible while the target is stopped once, in
+        // batches of up to capture_batch_size bytes
+        detail::ProcessPause pause;
+        double stopped = stop(pause, ctx.pid());
+        stats.consistent = pause.stopped();
+        std::size_t next = 0;
+        while (next < requests.size()) {
+            std::size_t last = next + 1;
+            std::size_t bytes = requests[next].size;
+            while (last < requests.size() &&
+                   bytes + requests[last].size <= detail::capture_batch_size) {
+                bytes += requests[last++].size;
+            }
+            copy_requests(ctx, requests, next, last, stats);
+            next = last;
+            if (pause.stopped() && next < requests.size() &&
+                max_pause_seconds > 0 &&
+                detail::stats_clock() - stopped > max_pause_seconds) {
+                stats.consistent = false;
+                break;
+            }
+        }
+        resume(pause, stopped, stats);
+
+        // The pause took too long, so copy the remaining regions (including
+        // any that were only partly copied) while stopping the target once
+        // for each
+        std::size_t region = std::upper_bound(region_requests.begin(),
+                                              region_requests.end(), next) -
+                             region_requests.begin() - 1;
+        for (; next < requests.size(); ++region) {
+            stopped = stop(pause, ctx.pid());
+            copy_requests(ctx, requests, region_requests[region],
+                          region_requests[region + 1], stats);
+            resume(pause, stopped, stats);
+            next = region_requests[region + 1];
+        }
+    }
+
+    static bool file_precedes(const CoreFile& left, const CoreFile& right) {
+        return left.start_address < right.start_address;
+    }
+
+    static bool file_starts_after(address_t address, const CoreFile& file) {
+        return address < file.start_address;
+    }
+
+    typedef std::pair<MemoryRegion, const byte_t*> RegionData;
+
+    static bool region_precedes(const RegionData& left,
+                                const RegionData& right) {
+        return left.first.start_address < right.first.start_address;
+    }
+
+    void sort_regions() {
+        std::vector<RegionData> regions;
+        for (std::size_t i = 0; i < m_loaded_regions.size(); ++i) {
+            regions.push_back(
+                std::make_pair(m_loaded_regions[i], m_region_data[i]));
+        }
+        std::stable_sort(regions.begin(), regions.end(), &region_precedes);
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            m_loaded_regions[i] = regions[i].first;
+            m_region_data[i] = regions[i].second;
+        }
+        publish_regions(m_loaded_regions);
+    }
+
+    const byte_t* m_map;
+    std::size_t m_map_size;
+
+    // The regions that have been loaded, until they are sorted and
+    // published
+    std::vector<MemoryRegion> m_loaded_regions;
+
+    // The bytes of each region in mapped_regions
+    std::vector<const byte_t*> m_region_data;
+};
+
+namespace detail {
+
+template <>
+struct InPlaceAccess<const SnapshotMemoryContext> {
+    static const byte_t* data(const SnapshotMemoryContext& ctx,
+                              address_t address, std::size_t size) {
+        return ctx.data(address, size);
+    }
+};
+
+template <>
+struct InPlaceAccess<SnapshotMemoryContext>
+    : public InPlaceAccess<const SnapshotMemoryContext> {};
+}
+}
+
+#endif
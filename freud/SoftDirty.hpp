@@ -0,0 +1,155 @@
+#ifndef FREUD_SOFT_DIRTY
+#define FREUD_SOFT_DIRTY
+
+#include "freud/Defines.hpp"
+#include "freud/LinuxReadBackend.hpp"
+#include <fcntl.h>
+#include <sstream>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+namespace freud {
+
+/** \brief Finds the pages of a process written since a checkpoint
+ *
+ * Linux keeps a 'soft-dirty' bit for each page of a process, which is set
+ * whenever the page is written. Writing "4" to /proc/<pid>/clear_refs
+ * clears the bits, and /proc/<pid>/pagemap exposes them.
+ *
+ * Soft-dirty tracking requires a kernel built with CONFIG_MEM_SOFT_DIRTY.
+ * available() reports whether it works on the running kernel.
+ */
+class SoftDirtyTracker {
+public:
+    explicit SoftDirtyTracker(unsigned long pid) : m_pid(pid), m_pagemap(-1) {
+        std::ostringstream ss;
+        ss << "/proc/" << pid << "/pagemap";
+        m_pagemap = open(ss.str().c_str(), O_RDONLY);
+    }
+
+    ~SoftDirtyTracker() {
+        if (m_pagemap >= 0) {
+            close(m_pagemap);
+        }
+    }
+
+    /// True if soft-dirty bits can be used to track this process
+    bool available() const { return m_pagemap >= 0 && kernel_supported(); }
+
+    /// Clear the soft-dirty bits of every page in the process
+    bool clear() { return clear_refs(m_pid); }
+
+    /// Append the ranges of pages in [start, end) that have been written
+    /// since the last call to clear
+    bool dirty_ranges(address_t start, address_t end,
+                      std::vector<AddressRange>& ranges) const {
+        return read_dirty_ranges(m_pagemap, start, end, ranges);
+    }
+
+    /// Test whether the running kernel maintains soft-dirty bits
+    /**
+     * The test writes to a page of the calling process, so it is only
+     * performed once. Clearing the calling process's bits is harmless, but
+     * makes its next write to each page take a minor fault.
+     */
+    static bool kernel_supported() {
+        static const bool supported = test_kernel_support();
+        return supported;
+    }
+
+private:
+    SoftDirtyTracker(const SoftDirtyTracker&);
+    SoftDirtyTracker& operator=(const SoftDirtyTracker&);
+
+    static const uint64_t soft_dirty_bit = uint64_t(1) << 55;
+
+    static bool clear_refs(unsigned long pid) {
+        std::ostringstream ss;
+        ss << "/proc/" << pid << "/clear_refs";
+        int fd = open(ss.str().c_str(), O_WRONLY);
+        if (fd < 0) {
+            return false;
+        }
+        bool result = write(fd, "4", 1) == 1;
+        close(fd);
+        return result;
+    }
+
+    static bool read_dirty_ranges(int pagemap, address_t start, address_t end,
+                                  std::vector<AddressRange>& ranges) {
+        if (pagemap < 0) {
+            return false;
+        }
+        const std::size_t page = detail::page_size();
+        const std::size_t batch = 4096;
+        uint64_t entries[batch];
+
+        address_t address = start - start % page;
+        while (address < end) {
+            std::size_t pages = (end - address + page - 1) / page;
+            if (pages > batch) {
+                pages = batch;
+            }
+            ssize_t result = pread(pagemap, entries, pages * sizeof(uint64_t),
+                                   (address / page) * sizeof(uint64_t));
+            if (result < static_cast<ssize_t>(sizeof(uint64_t))) {
+                return false;
+            }
+            pages = result / sizeof(uint64_t);
+
+            for (std::size_t i = 0; i < pages; ++i, address += page) {
+                if (!(entries[i] & soft_dirty_bit)) {
+                    continue;
+                }
+                address_t range_start = address < start ? start : address;
+                address_t range_end = address + page;
+                if (range_end > end) {
+                    range_end = end;
+                }
+                if (!ranges.empty() &&
+                    ranges.back().end_address == range_start) {
+                    ranges.back().end_address = range_end;
+                } else {
+                    AddressRange range = {range_start, range_end};
+                    ranges.push_back(range);
+                }
+            }
+        }
+        return true;
+    }
+
+    static bool test_kernel_support() {
+        const std::size_t page = detail::page_size();
+        void* memory = mmap(NULL, page, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            return false;
+        }
+        volatile byte_t* bytes = static_cast<volatile byte_t*>(memory);
+        address_t address = reinterpret_cast<address_t>(memory);
+
+        int pagemap = open("/proc/self/pagemap", O_RDONLY);
+        bool supported = false;
+        if (pagemap >= 0 && clear_refs(getpid())) {
+            std::vector<AddressRange> before;
+            std::vector<AddressRange> after;
+            read_dirty_ranges(pagemap, address, address + page, before);
+            bytes[0] = 1;
+            read_dirty_ranges(pagemap, address, address + page, after);
+            supported = before.empty() && !after.empty();
+        }
+        if (pagemap >= 0) {
+            close(pagemap);
+        }
+        munmap(memory, page);
+        return supported;
+    }
+
+    unsigned long m_pid;
+    int m_pagemap;
+};
+}
+
+#endif
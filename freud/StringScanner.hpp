@@ -0,0 +1,668 @@
+#ifndef FREUD_STRING_SCANNER
+#define FREUD_STRING_SCANNER
+
+#include "freud/MemoryContext.hpp"
+#include "freud/Prefilter.hpp"
+#include "freud/RangeScan.hpp"
+#include <algorithm>
+#include <cstring>
+#include <regex.h>
+#include <string>
+#include <vector>
+
+namespace freud {
+
+/// The encodings of strings found by a StringScanner
+enum StringEncoding {
+    /// Printable ASCII characters (and tabs)
+    STRING_ASCII = 1,
+
+    /// Printable ASCII characters and valid multi-byte UTF-8 sequences
+    STRING_UTF8 = 2,
+
+    /// Little-endian UTF-16 code units for printable ASCII and Latin-1
+    /// characters, starting at even addresses
+    STRING_UTF16LE = 4,
+
+    STRING_ALL_ENCODINGS = 7
+};
+
+/// The default number of bytes of a region that a StringScanner reads at
+/// once
+const std::size_t default_string_chunk_size = 4 * 1024 * 1024;
+
+/// The largest number of bytes a StringScanner reports for a single
+/// string. Longer strings are reported truncated to this size.
+const std::size_t max_string_size = 64 * 1024;
+
+/// A string found by a StringScanner
+struct FoundString {
+    StringEncoding encoding;
+
+    /// The number of characters in the string
+    std::size_t length;
+
+    /// The number of bytes in the string
+    std::size_t size;
+
+    /// The bytes of the string, which are only valid during the callback
+    const byte_t* data;
+
+    /// The string converted to UTF-8
+    std::string text() const {
+        if (encoding != STRING_UTF16LE) {
+            return std::string(data, size);
+        }
+        std::string result;
+        result.reserve(length);
+        for (std::size_t i = 0; i < size; i += 2) {
+            const unsigned char c = data[i];
+            if (c < 0x80) {
+                result += char(c);
+            } else {
+                result += char(0xC0 | (c >> 6));
+                result += char(0x80 | (c & 0x3F));
+            }
+        }
+        return result;
+    }
+};
+
+namespace detail {
+
+/// Classes of the bytes of a 64 byte block, with bit 'i' describing byte 'i'
+struct TextMasks {
+    /// Printable ASCII characters and tabs
+    uint64_t printable;
+
+    /// Bytes with the high bit set
+    uint64_t high;
+
+    /// Printable Latin-1 characters (0xA0 and above)
+    uint64_t latin1;
+
+    uint64_t zero;
+};
+
+typedef void (*ClassifyFunction)(const byte_t* block, TextMasks& masks);
+
+inline void classify_scalar(const byte_t* block, TextMasks& masks) {
+    masks.printable = masks.high = masks.latin1 = masks.zero = 0;
+    for (std::size_t i = 0; i < 64; ++i) {
+        const unsigned char c = block[i];
+        const uint64_t bit = uint64_t(1) << i;
+        if ((c >= 0x20 && c < 0x7F) || c == '\t') {
+            masks.printable |= bit;
+        } else if (c == 0) {
+            masks.zero |= bit;
+        } else if (c >= 0x80) {
+            masks.high |= bit;
+            if (c >= 0xA0) {
+                masks.latin1 |= bit;
+            }
+        }
+    }
+}
+
+#ifdef FREUD_X86_SIMD
+// Signed comparisons are used throughout, so the bytes 0x80 to 0xFF are
+// the negative values -128 to -1
+__attribute__((target("sse2"))) inline void
+classify_sse2(const byte_t* block, TextMasks& masks) {
+    const __m128i space = _mm_set1_epi8(0x1F);
+    const __m128i del = _mm_set1_epi8(0x7F);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i latin1 = _mm_set1_epi8(-0x61);
+    const __m128i zero = _mm_setzero_si128();
+
+    masks.printable = masks.high = masks.latin1 = masks.zero = 0;
+    for (std::size_t i = 0; i < 4; ++i) {
+        const __m128i bytes = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(block + i * 16));
+        const __m128i printable = _mm_or_si128(
+            _mm_and_si128(_mm_cmpgt_epi8(bytes, space),
+                          _mm_cmplt_epi8(bytes, del)),
+            _mm_cmpeq_epi8(bytes, tab));
+        const uint64_t high = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+        masks.printable |= uint64_t(static_cast<uint32_t>(
+                               _mm_movemask_epi8(printable)))
+                           << (i * 16);
+        masks.high |= high << (i * 16);
+        masks.latin1 |= (high & static_cast<uint32_t>(_mm_movemask_epi8(
+                                    _mm_cmpgt_epi8(bytes, latin1))))
+                        << (i * 16);
+        masks.zero |= uint64_t(static_cast<uint32_t>(
+                          _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero))))
+                      << (i * 16);
+    }
+}
+
+__attribute__((target("avx2"))) inline void
+classify_avx2(const byte_t* block, TextMasks& masks) {
+    const __m256i space = _mm256_set1_epi8(0x1F);
+    const __m256i del = _mm256_set1_epi8(0x7F);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i latin1 = _mm256_set1_epi8(-0x61);
+    const __m256i zero = _mm256_setzero_si256();
+
+    masks.printable = masks.high = masks.latin1 = masks.zero = 0;
+    for (std::size_t i = 0; i < 2; ++i) {
+        const __m256i bytes = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(block + i * 32));
+        const __m256i printable = _mm256_or_si256(
+            _mm256_and_si256(_mm256_cmpgt_epi8(bytes, space),
+                             _mm256_cmpgt_epi8(del, bytes)),
+            _mm256_cmpeq_epi8(bytes, tab));
+        const uint64_t high =
+            static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+        masks.printable |= uint64_t(static_cast<uint32_t>(
+                               _mm256_movemask_epi8(printable)))
+                           << (i * 32);
+        masks.high |= high << (i * 32);
+        masks.latin1 |= (high & static_cast<uint32_t>(_mm256_movemask_epi8(
+                                    _mm256_cmpgt_epi8(bytes, latin1))))
+                        << (i * 32);
+        masks.zero |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(
+                          _mm256_cmpeq_epi8(bytes, zero))))
+                      << (i * 32);
+    }
+}
+#endif
+
+/// Choose the fastest classification kernel supported by this CPU
+inline ClassifyFunction select_classify() {
+#ifdef FREUD_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &classify_avx2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return &classify_sse2;
+    }
+#endif
+    return &classify_scalar;
+}
+
+/// Classify the bytes of the 64 byte block at 'block'
+inline void classify(const byte_t* block, TextMasks& masks) {
+    static const ClassifyFunction function = select_classify();
+    function(block, masks);
+}
+
+/// The length of the valid UTF-8 sequence at 'p', or 0 if it is invalid
+/// (or does not end before 'end')
+inline std::size_t utf8_sequence(const unsigned char* p,
+                                 const unsigned char* end) {
+    const unsigned char c = p[0];
+    if (c < 0x80) {
+        return 1;
+    }
+
+    // The lead byte determines the length and the range of the second
+    // byte, which excludes overlong forms, surrogates and values above
+    // U+10FFFF
+    std::size_t length;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF) {
+        length = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        length = 3;
+        low = c == 0xE0 ? 0xA0 : 0x80;
+        high = c == 0xED ? 0x9F : 0xBF;
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        length = 4;
+        low = c == 0xF0 ? 0x90 : 0x80;
+        high = c == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return 0;
+    }
+    if (std::size_t(end - p) < length || p[1] < low || p[1] > high) {
+        return 0;
+    }
+    for (std::size_t i = 2; i < length; ++i) {
+        if (p[i] < 0x80 || p[i] > 0xBF) {
+            return 0;
+        }
+    }
+    return length;
+}
+
+/// The state of a run of text bytes that may continue into the next block
+struct TextRun {
+    bool open;
+    std::size_t start;
+};
+
+/// Pass each run of set bits in 'mask' (which describes the bytes from
+/// 'pos') that ends in this block to `handler.run(start, end)`
+template <typename Handler>
+void find_runs(uint64_t mask, std::size_t pos, TextRun& run,
+               Handler& handler) {
+    std::size_t bit = 0;
+    while (bit < 64) {
+        if (run.open) {
+            const uint64_t gaps = ~mask >> bit;
+            if (gaps == 0) {
+                return;
+            }
+            bit += lowest_bit(gaps);
+            run.open = false;
+            handler.run(run.start, pos + bit);
+        } else {
+            const uint64_t text = mask >> bit;
+            if (text == 0) {
+                return;
+            }
+            bit += lowest_bit(text);
+            run.open = true;
+            run.start = pos + bit;
+        }
+    }
+}
+}
+
+/** \brief Finds the strings in a context
+ *
+ * This is the equivalent of the `strings` utility for a context. Each
+ * chunk of a region is classified 64 bytes at a time with SIMD
+ * instructions (where available), so runs of text are found at close to
+ * the speed at which memory can be read, and only those runs are examined
+ * byte by byte.
+ *
+ * \code{.c}
+ * struct PrintString {
+ *     void operator()(address_t address, const FoundString& s) {
+ *         std::cout << std::hex << address << ": " << s.text() << "\n";
+ *     }
+ * };
+ *
+ * StringScanner<> scanner(ctx);
+ * scanner.set_min_length(8);
+ * scanner.scan(PrintString());
+ * \endcode
+ *
+ * Every region of the context is scanned, so a context created with a
+ * RegionFilter (such as RegionFilter::heap_only) limits where strings are
+ * looked for. A run of printable ASCII is reported as STRING_ASCII if that
+ * encoding is enabled, and as STRING_UTF8 otherwise. Strings are not
+ * required to be terminated.
+ */
+template <typename Context = MemoryContext>
+class StringScanner {
+public:
+    explicit StringScanner(
+        Context& ctx, std::size_t chunk_size = default_string_chunk_size)
+        : m_ctx(ctx), m_chunk_size(chunk_size < 64 ? 64 : chunk_size & ~63),
+          m_encodings(STRING_ALL_ENCODINGS), m_min_length(4),
+          m_max_length(0), m_has_regex(false), m_bytes_scanned(0) {}
+
+    ~StringScanner() {
+        if (m_has_regex) {
+            regfree(&m_regex);
+        }
+    }
+
+    /// Select the StringEncodings to look for (all of them by default)
+    void set_encodings(unsigned encodings) { m_encodings = encodings; }
+
+    /// Only report strings of at least 'length' characters (4 by default)
+    void set_min_length(std::size_t length) {
+        m_min_length = length == 0 ? 1 : length;
+    }
+
+    /// Truncate strings to at most 'length' characters (0, the default,
+    /// only truncates them to max_string_size bytes)
+    void set_max_length(std::size_t length) { m_max_length = length; }
+
+    /// Only report strings containing 'substring' (as UTF-8). An empty
+    /// substring removes the filter.
+    void set_substring(const std::string& substring) {
+        m_substring = substring;
+    }
+
+    /// Only report strings matching a POSIX regular expression
+    /**
+     * The expression is matched against the text of each string (as
+     * UTF-8), and may match any part of it. An empty pattern removes the
+     * filter.
+     *
+     * \returns false if the pattern is invalid, in which case there is no
+     *          regular expression filter
+     */
+    bool set_regex(const std::string& pattern, int flags = REG_EXTENDED) {
+        if (m_has_regex) {
+            regfree(&m_regex);
+            m_has_regex = false;
+        }
+        if (pattern.empty()) {
+            return true;
+        }
+        m_has_regex =
+            regcomp(&m_regex, pattern.c_str(), flags | REG_NOSUB) == 0;
+        return m_has_regex;
+    }
+
+    /// Find the strings in every region
+    /**
+     * The context's mapped regions are updated first.
+     * `callback(address, string)` is invoked with a FoundString for every
+     * string, in address order for each encoding.
+     *
+     * \returns The number of strings found
+     */
+    template <typename Callback>
+    std::size_t scan(Callback callback) {
+        typedef typename Context::MemoryRegion MemoryRegion;
+
+        m_ctx.update_regions();
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+        m_bytes_scanned = 0;
+
+        Walk<Callback> walk(*this, callback);
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            const address_t end = regions[i].end_address;
+            for (address_t chunk = regions[i].start_address; chunk < end;
+                 chunk += m_chunk_size) {
+                walk.scan_chunk(regions[i].start_address, chunk, end);
+            }
+        }
+        return walk.found;
+    }
+
+    /// The number of bytes that were read and classified by the last scan
+    std::size_t bytes_scanned() const { return m_bytes_scanned; }
+
+private:
+    StringScanner(const StringScanner&);
+    StringScanner& operator=(const StringScanner&);
+
+    /// The state of one scan
+    template <typename Callback>
+    struct Walk {
+        Walk(StringScanner& scanner, Callback& callback)
+            : scanner(scanner), callback(callback), found(0), data(NULL),
+              base(0), size(0), first(0), limit(0), more(false), resume(0),
+              resume_in_piece(false) {
+            narrow.walk = this;
+            wide.walk = this;
+        }
+
+        /// Handles the runs of ASCII and UTF-8 text
+        struct NarrowRuns {
+            Walk* walk;
+
+            void run(std::size_t start, std::size_t end) {
+                walk->narrow_run(start, end);
+            }
+        };
+
+        /// Handles the runs of UTF-16 code units
+        struct WideRuns {
+            Walk* walk;
+
+            void run(std::size_t start, std::size_t end) {
+                walk->wide_run(start, end);
+            }
+        };
+
+        /// Find the strings starting in [chunk, chunk + chunk_size)
+        /**
+         * Two bytes before the chunk are read as well, so strings that
+         * continue from the previous chunk (and were reported with it) can
+         * be recognized. The bytes after the chunk are read so strings that
+         * start in it can be reported whole, up to max_string_size bytes.
+         * The pieces of a narrow run that start past the chunk are left to
+         * the chunk they start in (see 'resume').
+         */
+        void scan_chunk(address_t region_start, address_t chunk,
+                        address_t region_end) {
+            const std::size_t lead = chunk - region_start < 2 ? 0 : 2;
+            address_t read_end = chunk + scanner.m_chunk_size;
+            address_t scan_end = read_end;
+            if (scan_end > region_end || scan_end < chunk) {
+                scan_end = read_end = region_end;
+            } else {
+                read_end += max_string_size;
+                if (read_end > region_end || read_end < scan_end) {
+                    read_end = region_end;
+                }
+            }
+
+            base = chunk - lead;
+            size = read_end - base;
+            more = read_end < region_end;
+            if (chunk == region_start) {
+                resume = 0;
+            }
+            data = reinterpret_cast<const unsigned char*>(
+                detail::read_range(scanner.m_ctx, base, size,
+                                   scanner.m_scratch));
+            first = lead;
+            limit = scan_end - base;
+
+            const bool find_narrow =
+                scanner.m_encodings & (STRING_ASCII | STRING_UTF8);
+            const bool find_wide = scanner.m_encodings & STRING_UTF16LE;
+            const uint64_t multibyte =
+                scanner.m_encodings & STRING_UTF8 ? ~uint64_t(0) : 0;
+            const uint64_t even = 0x5555555555555555ULL;
+
+            detail::TextRun narrow_text = {false, 0};
+            detail::TextRun wide_text = {false, 0};
+            std::size_t pos = 0;
+            for (; pos < size; pos += 64) {
+                if (pos >= limit && !narrow_text.open && !wide_text.open) {
+                    break;
+                }
+
+                detail::TextMasks masks;
+                if (size - pos >= 64) {
+                    detail::classify(
+                        reinterpret_cast<const byte_t*>(data + pos), masks);
+                } else {
+                    // The bytes past the end are zero, so every run ends
+                    // with the buffer
+                    byte_t tail[64] = {0};
+                    std::memcpy(tail, data + pos, size - pos);
+                    detail::classify(tail, masks);
+                }
+
+                if (find_narrow) {
+                    detail::find_runs(masks.printable |
+                                          (masks.high & multibyte),
+                                      pos, narrow_text, narrow);
+                }
+                if (find_wide) {
+                    // A code unit is a printable low byte followed by a
+                    // zero, and covers both bits
+                    const uint64_t units = (masks.printable | masks.latin1) &
+                                           (masks.zero >> 1) & even;
+                    detail::find_runs(units | (units << 1), pos, wide_text,
+                                      wide);
+                }
+            }
+            if (narrow_text.open) {
+                narrow_run(narrow_text.start, size);
+            }
+            if (wide_text.open) {
+                wide_run(wide_text.start, size);
+            }
+            scanner.m_bytes_scanned += std::min(pos, size);
+        }
+
+        /// Split a run of text bytes at invalid UTF-8 sequences
+        /**
+         * Each piece is reported by the chunk it starts in, and truncated on
+         * its own. The pieces of a run that continues from an earlier chunk
+         * are picked up at 'resume'.
+         */
+        void narrow_run(std::size_t start, std::size_t end) {
+            std::size_t from = start;
+            bool in_piece = false;
+            if (start < first) {
+                if (resume < base + first || resume >= base + end) {
+                    return;
+                }
+                if (resume >= base + limit) {
+                    // The next piece starts in a later chunk
+                    return;
+                }
+                from = resume - base;
+                in_piece = resume_in_piece;
+                resume = 0;
+            } else if (start >= limit || end - start < scanner.m_min_length) {
+                return;
+            }
+
+            // The run may continue past the bytes that were read
+            const bool open = more && end == size;
+            const unsigned char* const stop = data + end;
+            const unsigned char* piece = data + from;
+            const unsigned char* p = piece;
+            std::size_t length = 0;
+            bool multibyte = false;
+            bool truncated = in_piece;
+            while (p < stop) {
+                if (p == piece && !in_piece &&
+                    std::size_t(p - data) >= limit) {
+                    resume = base + (p - data);
+                    resume_in_piece = false;
+                    return;
+                }
+                in_piece = false;
+                const std::size_t sequence = detail::utf8_sequence(p, stop);
+                if (sequence == 0) {
+                    if (open && stop - p < 4) {
+                        // The sequence may end past the bytes that were
+                        // read
+                        break;
+                    }
+                    if (!truncated) {
+                        report_narrow(piece, p, length, multibyte);
+                    }
+                    piece = ++p;
+                    length = 0;
+                    multibyte = false;
+                    truncated = false;
+                    continue;
+                }
+                if (!truncated &&
+                    ((scanner.m_max_length != 0 &&
+                      length == scanner.m_max_length) ||
+                     std::size_t(p - piece) + sequence > max_string_size)) {
+                    report_narrow(piece, p, length, multibyte);
+                    truncated = true;
+                }
+                ++length;
+                multibyte |= sequence > 1;
+                p += sequence;
+            }
+            if (!truncated) {
+                report_narrow(piece, p, length, multibyte);
+            }
+            if (open) {
+                // The rest of the piece (which has been reported) and the
+                // pieces after it are found by the chunk that 'p' is in
+                resume = base + (p - data);
+                resume_in_piece = p != piece;
+            }
+        }
+
+        void report_narrow(const unsigned char* begin,
+                           const unsigned char* end, std::size_t length,
+                           bool multibyte) {
+            StringEncoding encoding =
+                multibyte || !(scanner.m_encodings & STRING_ASCII)
+                    ? STRING_UTF8
+                    : STRING_ASCII;
+            report(begin, end - begin, length, encoding);
+        }
+
+        void wide_run(std::size_t start, std::size_t end) {
+            if (start < first || start >= limit ||
+                (end - start) / 2 < scanner.m_min_length) {
+                return;
+            }
+            std::size_t length = (end - start) / 2;
+            if (length > max_string_size / 2) {
+                length = max_string_size / 2;
+            }
+            if (scanner.m_max_length != 0 && length > scanner.m_max_length) {
+                length = scanner.m_max_length;
+            }
+            report(data + start, length * 2, length, STRING_UTF16LE);
+        }
+
+        void report(const unsigned char* bytes, std::size_t size,
+                    std::size_t length, StringEncoding encoding) {
+            if (length < scanner.m_min_length) {
+                return;
+            }
+            FoundString string;
+            string.encoding = encoding;
+            string.length = length;
+            string.size = size;
+            string.data = reinterpret_cast<const byte_t*>(bytes);
+            if (!scanner.accepts(string)) {
+                return;
+            }
+            callback(base + (bytes - data), string);
+            ++found;
+        }
+
+        StringScanner& scanner;
+        Callback& callback;
+        std::size_t found;
+
+        NarrowRuns narrow;
+        WideRuns wide;
+
+        // The 'size' bytes read for the current chunk, from the address
+        // 'base'. Strings are reported if they start in [first, limit).
+        const unsigned char* data;
+        address_t base;
+        std::size_t size;
+        std::size_t first;
+        std::size_t limit;
+        // Whether the region continues past the bytes that were read
+        bool more;
+
+        // Where the next piece of a narrow run that continues past the
+        // bytes that were read (or past 'limit') must be picked up, or 0.
+        // If 'resume_in_piece', it is part way through a piece that has
+        // already been reported.
+        address_t resume;
+        bool resume_in_piece;
+    };
+
+    /// Apply the substring and regular expression filters
+    bool accepts(const FoundString& string) const {
+        if (m_substring.empty() && !m_has_regex) {
+            return true;
+        }
+        const std::string text = string.text();
+        if (!m_substring.empty() &&
+            text.find(m_substring) == std::string::npos) {
+            return false;
+        }
+        return !m_has_regex ||
+               regexec(&m_regex, text.c_str(), 0, NULL, 0) == 0;
+    }
+
+    Context& m_ctx;
+    std::size_t m_chunk_size;
+    detail::ScanScratch m_scratch;
+
+    unsigned m_encodings;
+    std::size_t m_min_length;
+    std::size_t m_max_length;
+    std::string m_substring;
+    regex_t m_regex;
+    bool m_has_regex;
+
+    std::size_t m_bytes_scanned;
+};
+}
+
+#endif
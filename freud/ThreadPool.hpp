@@ -0,0 +1,195 @@
+#ifndef FREUD_THREAD_POOL
+#define FREUD_THREAD_POOL
+
+#include <deque>
+#include <pthread.h>
+#include <vector>
+
+namespace freud {
+namespace detail {
+
+/// A thin wrapper around a pthread mutex
+class Mutex {
+public:
+    Mutex() { pthread_mutex_init(&m_mutex, NULL); }
+    ~Mutex() { pthread_mutex_destroy(&m_mutex); }
+
+    void lock() { pthread_mutex_lock(&m_mutex); }
+    void unlock() { pthread_mutex_unlock(&m_mutex); }
+
+private:
+    friend class Condition;
+
+    Mutex(const Mutex&);
+    Mutex& operator=(const Mutex&);
+
+    pthread_mutex_t m_mutex;
+};
+
+/// Holds a Mutex for the lifetime of the ScopedLock
+class ScopedLock {
+public:
+    explicit ScopedLock(Mutex& mutex) : m_mutex(mutex) { m_mutex.lock(); }
+    ~ScopedLock() { m_mutex.unlock(); }
+
+private:
+    ScopedLock(const ScopedLock&);
+    ScopedLock& operator=(const ScopedLock&);
+
+    Mutex& m_mutex;
+};
+
+/// A thin wrapper around a pthread condition variable
+class Condition {
+public:
+    Condition() { pthread_cond_init(&m_cond, NULL); }
+    ~Condition() { pthread_cond_destroy(&m_cond); }
+
+    void wait(Mutex& mutex) { pthread_cond_wait(&m_cond, &mutex.m_mutex); }
+    void signal() { pthread_cond_signal(&m_cond); }
+    void broadcast() { pthread_cond_broadcast(&m_cond); }
+
+private:
+    Condition(const Condition&);
+    Condition& operator=(const Condition&);
+
+    pthread_cond_t m_cond;
+};
+
+/// A unit of work that may be executed by a ThreadPool
+class Task {
+public:
+    virtual ~Task() {}
+
+    /// Execute the task on the worker with the given index. The index is
+    /// in the range [0, ThreadPool::size()), and may be used to select
+    /// per-worker scratch space.
+    virtual void run(unsigned worker) = 0;
+};
+
+/** \brief A fixed size thread pool with a single locked queue
+ *
+ * Submitted tasks are run in the order they were submitted, by whichever
+ * worker is free first. The tasks freud submits each scan a chunk of at
+ * least tens of kilobytes, so one lock per task is not a bottleneck. The
+ * pool does not take ownership of submitted tasks.
+ *
+ * If no worker thread can be started (for example, because of a limit on
+ * the number of threads), the tasks are run by the thread calling `wait`.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threads)
+        : m_size(threads ? threads : 1), m_pending(0), m_stopping(false) {
+        m_workers.reserve(m_size);
+        for (unsigned i = 0; i < m_size; ++i) {
+            Worker worker = {this, i};
+            m_workers.push_back(worker);
+        }
+        m_threads.reserve(m_size);
+        for (unsigned i = 0; i < m_size; ++i) {
+            pthread_t thread;
+            if (pthread_create(&thread, NULL, &ThreadPool::worker_main,
+                               &m_workers[i]) == 0) {
+                m_threads.push_back(thread);
+            }
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            ScopedLock lock(m_mutex);
+            m_stopping = true;
+            m_work_available.broadcast();
+        }
+        for (std::size_t i = 0; i < m_threads.size(); ++i) {
+            pthread_join(m_threads[i], NULL);
+        }
+    }
+
+    /// The number of workers in the pool, which bounds the worker index
+    /// passed to Task::run
+    unsigned size() const { return m_size; }
+
+    /// Queue a task for execution. This may be called from any thread,
+    /// including from within a running task.
+    void submit(Task* task) {
+        ScopedLock lock(m_mutex);
+        m_tasks.push_back(task);
+        ++m_pending;
+        m_work_available.signal();
+    }
+
+    /// Block until every submitted task has finished executing
+    void wait() {
+        ScopedLock lock(m_mutex);
+        if (m_threads.empty()) {
+            // No worker started, so run the tasks here as worker 0
+            while (!m_tasks.empty()) {
+                Task* task = m_tasks.front();
+                m_tasks.pop_front();
+                m_mutex.unlock();
+                task->run(0);
+                m_mutex.lock();
+                --m_pending;
+            }
+        }
+        while (m_pending > 0) {
+            m_all_done.wait(m_mutex);
+        }
+    }
+
+private:
+    struct Worker {
+        ThreadPool* pool;
+        unsigned index;
+    };
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    static void* worker_main(void* arg) {
+        Worker* worker = static_cast<Worker*>(arg);
+        worker->pool->run_worker(worker->index);
+        return NULL;
+    }
+
+    void run_worker(unsigned index) {
+        ScopedLock lock(m_mutex);
+        for (;;) {
+            while (m_tasks.empty() && !m_stopping) {
+                m_work_available.wait(m_mutex);
+            }
+            if (m_tasks.empty()) {
+                return;
+            }
+            Task* task = m_tasks.front();
+            m_tasks.pop_front();
+
+            m_mutex.unlock();
+            task->run(index);
+            m_mutex.lock();
+
+            if (--m_pending == 0) {
+                m_all_done.broadcast();
+            }
+        }
+    }
+
+    unsigned m_size;
+    std::vector<Worker> m_workers;
+
+    // The threads that were started, which may be fewer than m_size
+    std::vector<pthread_t> m_threads;
+
+    Mutex m_mutex;
+    Condition m_work_available;
+    Condition m_all_done;
+    std::deque<Task*> m_tasks;
+    std::size_t m_pending;
+    bool m_stopping;
+};
+}
+}
+
+#endif
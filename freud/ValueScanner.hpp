@@ -0,0 +1,432 @@
+#ifndef FREUD_VALUE_SCANNER
+#define FREUD_VALUE_SCANNER
+
+#include "freud/Alignment.hpp"
+#include "freud/MemoryContext.hpp"
+#include "freud/Prefilter.hpp"
+#include "freud/RangeScan.hpp"
+#include <cstring>
+#include <stdint.h>
+#include <vector>
+
+namespace freud {
+
+/// The default number of bytes read at once by a ValueScanner
+const std::size_t default_value_scan_chunk_size = 4 * 1024 * 1024;
+
+/// A ValueScanner::rescan predicate keeping the values that changed
+struct ValueChanged {
+    template <typename T>
+    bool operator()(const T& old_value, const T& new_value) const {
+        return !(old_value == new_value);
+    }
+};
+
+/// A ValueScanner::rescan predicate keeping the values that did not change
+struct ValueUnchanged {
+    template <typename T>
+    bool operator()(const T& old_value, const T& new_value) const {
+        return old_value == new_value;
+    }
+};
+
+/// A ValueScanner::rescan predicate keeping the values that increased
+struct ValueIncreased {
+    template <typename T>
+    bool operator()(const T& old_value, const T& new_value) const {
+        return old_value < new_value;
+    }
+};
+
+/// A ValueScanner::rescan predicate keeping the values that decreased
+struct ValueDecreased {
+    template <typename T>
+    bool operator()(const T& old_value, const T& new_value) const {
+        return new_value < old_value;
+    }
+};
+
+/** \brief Finds a value by narrowing a set of candidate addresses
+ *
+ * A ValueScanner supports the common workflow of searching for a value
+ * (such as a game's score), letting the target change it, and keeping only
+ * the addresses whose value changed in the same way. The first `scan`
+ * checks every aligned offset of every region. Each `rescan` only reads
+ * the pages that still hold candidates (in one `read_batch`), and keeps
+ * the candidates for which `predicate(old_value, new_value)` is true:
+ *
+ * \code{.c}
+ * ValueScanner<int> scanner(ctx);
+ * scanner.scan_for(100);
+ * // ... the score goes up ...
+ * scanner.rescan(ValueIncreased());
+ * // ... the score goes down ...
+ * scanner.rescan(ValueDecreased());
+ * \endcode
+ *
+ * Candidates are stored as a bitmap for each page that holds any, along
+ * with the value each had in the last scan, so the memory used and the
+ * cost of a rescan grow with the number of candidates rather than with
+ * the size of the address space. A candidate whose bytes can no longer be
+ * read is dropped.
+ */
+template <typename T, typename Context = MemoryContext>
+class ValueScanner {
+public:
+    static const std::size_t alignment = detail::alignment_of<T>::value;
+
+    explicit ValueScanner(
+        Context& ctx, std::size_t chunk_size = default_value_scan_chunk_size)
+        : m_ctx(ctx), m_chunk_size(chunk_size),
+          m_page_size(detail::page_size()),
+          m_words_per_page((m_page_size / alignment + 63) / 64),
+          m_size(0), m_bytes_read(0) {}
+
+    /// Start again with the values in every region for which
+    /// `predicate(value)` is true
+    /**
+     * The context's mapped regions are updated first.
+     *
+     * \returns The number of candidates
+     */
+    template <typename Predicate>
+    std::size_t scan(Predicate predicate) {
+        typedef typename Context::MemoryRegion MemoryRegion;
+
+        clear();
+        m_ctx.update_regions();
+        const std::vector<MemoryRegion>& regions = m_ctx.mapped_regions();
+        std::size_t chunk_size = m_chunk_size - m_chunk_size % m_page_size;
+        if (chunk_size == 0) {
+            chunk_size = m_page_size;
+        }
+
+        Candidates found(m_page_size, m_words_per_page);
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            const address_t end = regions[i].end_address;
+            for (address_t chunk = regions[i].start_address; chunk < end;
+                 chunk += chunk_size) {
+                address_t scan_end = chunk + chunk_size;
+                if (scan_end > end || scan_end < chunk) {
+                    scan_end = end;
+                }
+                address_t read_end = scan_end + sizeof(T) - 1;
+                if (read_end > end || read_end < scan_end) {
+                    read_end = end;
+                }
+                const std::size_t length = read_end - chunk;
+                const byte_t* data =
+                    detail::read_range(m_ctx, chunk, length, m_scratch);
+                m_bytes_read += length;
+
+                FailedCursor failed(m_scratch.failed);
+                for (std::size_t offset = 0;
+                     offset < scan_end - chunk &&
+                     offset + sizeof(T) <= length;
+                     offset += alignment) {
+                    const address_t address = chunk + offset;
+                    if (failed.overlaps(address, sizeof(T))) {
+                        continue;
+                    }
+                    detail::ObjectStorage<T> value;
+                    std::memcpy(value.bytes, data + offset, sizeof(T));
+                    if (predicate(value.get())) {
+                        found.add(address, data + offset);
+                    }
+                }
+            }
+        }
+        found.swap(*this);
+        return m_size;
+    }
+
+    /// Start again with the values equal to 'value'
+    /**
+     * \returns The number of candidates
+     */
+    std::size_t scan_for(const T& value) {
+        Equals equals = {value};
+        return scan(equals);
+    }
+
+    /// Read the candidates again, keeping those for which
+    /// `predicate(old_value, new_value)` is true
+    /**
+     * 'old_value' is the value read by the previous scan or rescan. The
+     * pages holding candidates are read in batches of about 'chunk_size'
+     * bytes, with adjacent pages combined into a single request.
+     *
+     * \returns The number of candidates that remain
+     */
+    template <typename Predicate>
+    std::size_t rescan(Predicate predicate) {
+        m_bytes_read = 0;
+        Candidates kept(m_page_size, m_words_per_page);
+        for (std::size_t first = 0; first < m_pages.size();) {
+            const std::size_t last = read_pages(first);
+
+            FailedCursor failed(m_scratch.failed);
+            for (std::size_t p = first; p < last; ++p) {
+                const Page& page = m_pages[p];
+                const byte_t* data = &m_scratch.buffer[page.data_offset];
+                const byte_t* old_value = &m_values[page.first_value];
+                for (std::size_t w = 0; w < m_words_per_page; ++w) {
+                    uint64_t word = m_bits[page.first_word + w];
+                    while (word != 0) {
+                        const std::size_t bit =
+                            w * 64 + detail::lowest_bit(word);
+                        word &= word - 1;
+
+                        const address_t address =
+                            page.address + bit * alignment;
+                        const byte_t* bytes =
+                            data + (address - page.span_start);
+                        if (!failed.overlaps(address, sizeof(T)) &&
+                            predicate(object(old_value), object(bytes))) {
+                            kept.add(address, bytes);
+                        }
+                        old_value += sizeof(T);
+                    }
+                }
+            }
+            first = last;
+        }
+        kept.swap(*this);
+        return m_size;
+    }
+
+    /// The number of candidates
+    std::size_t size() const { return m_size; }
+
+    /// Invoke `callback(address, value)` for every candidate, in address
+    /// order, with the value read by the last scan or rescan
+    template <typename Callback>
+    void for_each(Callback callback) const {
+        const byte_t* value = m_values.empty() ? NULL : &m_values[0];
+        for (std::size_t p = 0; p < m_pages.size(); ++p) {
+            for (std::size_t w = 0; w < m_words_per_page; ++w) {
+                uint64_t word = m_bits[m_pages[p].first_word + w];
+                while (word != 0) {
+                    const std::size_t bit = w * 64 + detail::lowest_bit(word);
+                    word &= word - 1;
+                    callback(m_pages[p].address + bit * alignment,
+                             object(value));
+                    value += sizeof(T);
+                }
+            }
+        }
+    }
+
+    /// The addresses of every candidate, in increasing order
+    std::vector<address_t> addresses() const {
+        std::vector<address_t> result;
+        result.reserve(m_size);
+        AddressCollector collector = {&result};
+        for_each(collector);
+        return result;
+    }
+
+    /// Forget every candidate
+    void clear() {
+        std::vector<Page>().swap(m_pages);
+        std::vector<uint64_t>().swap(m_bits);
+        std::vector<byte_t>().swap(m_values);
+        m_size = 0;
+        m_bytes_read = 0;
+    }
+
+    /// The number of bytes read from the target by the last scan or rescan
+    std::size_t bytes_read() const { return m_bytes_read; }
+
+private:
+    ValueScanner(const ValueScanner&);
+    ValueScanner& operator=(const ValueScanner&);
+
+    /// A page holding at least one candidate
+    struct Page {
+        address_t address;
+
+        // The index of the page's bitmap in m_bits, and of its first value
+        // in m_values
+        std::size_t first_word;
+        std::size_t first_value;
+
+        // The bytes read for the page during a rescan: from 'span_start'
+        // (the first candidate) at 'data_offset' in the scratch buffer
+        address_t span_start;
+        std::size_t data_offset;
+    };
+
+    /// The candidates found by a scan, added in increasing address order
+    struct Candidates {
+        Candidates(std::size_t page_size, std::size_t words_per_page)
+            : page_size(page_size), words_per_page(words_per_page),
+              size(0) {}
+
+        void add(address_t address, const byte_t* value) {
+            const address_t page = address - address % page_size;
+            if (pages.empty() || pages.back().address != page) {
+                Page entry = {page, bits.size(), values.size(), 0, 0};
+                pages.push_back(entry);
+                bits.resize(bits.size() + words_per_page, 0);
+            }
+            const std::size_t bit = (address - page) / alignment;
+            bits[pages.back().first_word + bit / 64] |= uint64_t(1)
+                                                        << (bit % 64);
+            values.insert(values.end(), value, value + sizeof(T));
+            ++size;
+        }
+
+        void swap(ValueScanner& scanner) {
+            scanner.m_pages.swap(pages);
+            scanner.m_bits.swap(bits);
+            scanner.m_values.swap(values);
+            scanner.m_size = size;
+        }
+
+        std::size_t page_size;
+        std::size_t words_per_page;
+        std::vector<Page> pages;
+        std::vector<uint64_t> bits;
+        std::vector<byte_t> values;
+        std::size_t size;
+    };
+
+    /// Tests addresses, in increasing order, against a sorted list of
+    /// ranges that could not be read
+    class FailedCursor {
+    public:
+        explicit FailedCursor(const std::vector<FailedRange>& failed)
+            : m_failed(failed), m_next(0) {}
+
+        bool overlaps(address_t address, std::size_t size) {
+            while (m_next < m_failed.size() &&
+                   m_failed[m_next].end_address <= address) {
+                ++m_next;
+            }
+            return m_next < m_failed.size() &&
+                   m_failed[m_next].start_address < address + size;
+        }
+
+    private:
+        const std::vector<FailedRange>& m_failed;
+        std::size_t m_next;
+    };
+
+    struct Equals {
+        T value;
+
+        bool operator()(const T& other) const { return other == value; }
+    };
+
+    struct AddressCollector {
+        std::vector<address_t>* addresses;
+
+        void operator()(address_t address, const T&) {
+            addresses->push_back(address);
+        }
+    };
+
+    static T object(const byte_t* bytes) {
+        detail::ObjectStorage<T> storage;
+        std::memcpy(storage.bytes, bytes, sizeof(T));
+        return storage.get();
+    }
+
+    /// Read the candidates of the pages starting at 'first' into
+    /// m_scratch, combining adjacent pages into one request
+    /**
+     * \returns The index of the page after the last one read
+     */
+    std::size_t read_pages(std::size_t first) {
+        m_scratch.requests.clear();
+        m_scratch.failed.clear();
+        std::size_t total = 0;
+        std::size_t last = first;
+        for (; last < m_pages.size() &&
+               (last == first || total < m_chunk_size);
+             ++last) {
+            Page& page = m_pages[last];
+            std::size_t low = 0;
+            std::size_t high = 0;
+            bool any = false;
+            for (std::size_t w = 0; w < m_words_per_page; ++w) {
+                const uint64_t word = m_bits[page.first_word + w];
+                if (word == 0) {
+                    continue;
+                }
+                if (!any) {
+                    low = w * 64 + detail::lowest_bit(word);
+                    any = true;
+                }
+                high = w * 64 + 63 - highest_bit(word);
+            }
+            page.span_start = page.address + low * alignment;
+            const address_t span_end =
+                page.address + high * alignment + sizeof(T);
+
+            if (!m_scratch.requests.empty()) {
+                ReadRequest& previous = m_scratch.requests.back();
+                const address_t previous_end =
+                    previous.address + previous.size;
+                if (page.span_start <= previous_end) {
+                    page.data_offset =
+                        total - (previous_end - page.span_start);
+                    if (span_end > previous_end) {
+                        previous.size += span_end - previous_end;
+                        total += span_end - previous_end;
+                    }
+                    continue;
+                }
+            }
+            ReadRequest request = {page.span_start, NULL,
+                                   span_end - page.span_start, 0};
+            m_scratch.requests.push_back(request);
+            page.data_offset = total;
+            total += request.size;
+        }
+
+        m_scratch.buffer.resize(total);
+        std::size_t offset = 0;
+        for (std::size_t r = 0; r < m_scratch.requests.size(); ++r) {
+            m_scratch.requests[r].buffer = &m_scratch.buffer[offset];
+            offset += m_scratch.requests[r].size;
+        }
+        m_ctx.read_batch(m_scratch.requests, &m_scratch.failed);
+        m_bytes_read += total;
+        return last;
+    }
+
+    /// The number of leading zero bits of a non-zero word
+    static unsigned highest_bit(uint64_t word) {
+#if defined __GNUC__ || defined __clang__
+        return __builtin_clzll(word);
+#else
+        unsigned bits = 0;
+        while (!(word & (uint64_t(1) << 63))) {
+            word <<= 1;
+            ++bits;
+        }
+        return bits;
+#endif
+    }
+
+    Context& m_ctx;
+    std::size_t m_chunk_size;
+    std::size_t m_page_size;
+    std::size_t m_words_per_page;
+    detail::ScanScratch m_scratch;
+
+    // The candidates, by page, in address order. Each page's bitmap has a
+    // bit for every aligned offset in it. The values of the candidates are
+    // stored in the same order.
+    std::vector<Page> m_pages;
+    std::vector<uint64_t> m_bits;
+    std::vector<byte_t> m_values;
+    std::size_t m_size;
+
+    std::size_t m_bytes_read;
+};
+}
+
+#endif
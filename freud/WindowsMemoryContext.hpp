@@ -1,6 +1,7 @@
 #ifndef FREUD_WINDOWS_MEMORY_CONTEXT
 #define FREUD_WINDOWS_MEMORY_CONTEXT
 
+#include "freud/AlignedBuffer.hpp"
 #include "freud/MemoryContext.hpp"
 #include <windows.h>
 
@@ -14,13 +15,14 @@ public:
 
     ~WindowsMemoryContext() {}
 
-    bool read(address_t address, std::vector<char>& buffer) {
+    bool read(address_t address, std::vector<char>& buffer) const {
         return read(address, buffer, region_containing(address));
     }
 
-    bool
-    read(address_t address, std::vector<char>& buffer,
-         std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter) {
+    bool read(
+        address_t address, std::vector<char>& buffer,
+        std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter)
+        const {
         SIZE_T bytes_read;
         bool res =
             ReadProcessMemory(m_proc_handle, (LPCVOID)address, &*buffer.begin(),
@@ -28,8 +30,66 @@ public:
         return res;
     }
 
+    /// Read a T from 'address' (see LinuxMemoryContext::read)
+    template <typename T>
+    T read(address_t address, bool* ok = NULL) const {
+        detail::ObjectStorage<T> storage;
+        std::vector<char> buffer(sizeof(T));
+        const bool result = read(address, buffer);
+        if (!result) {
+            std::fill(buffer.begin(), buffer.end(), 0);
+        }
+        std::memcpy(storage.bytes, &buffer[0], sizeof(T));
+        if (ok) {
+            *ok = result;
+        }
+        return storage.get();
+    }
+
+    /// Get a pointer to the cached bytes at an address (see
+    /// LinuxMemoryContext::view)
+    bool view(address_t address,
+              std::vector<BaseMemoryContext::MemoryRegion>::const_iterator iter,
+              const byte_t*& data, std::size_t& available,
+              std::size_t size = 1) {
+        if (address < iter->start_address || address >= iter->end_address) {
+            return false;
+        }
+
+        if (m_cache.empty() ||
+            m_cached_region.start_address != iter->start_address ||
+            m_cached_region.end_address != iter->end_address) {
+            m_cached_region = *iter;
+            m_cache.resize(iter->end_address - iter->start_address);
+
+            SIZE_T bytes_read = 0;
+            bool result = ReadProcessMemory(m_proc_handle,
+                                            (LPCVOID)iter->start_address,
+                                            m_cache.data(), m_cache.size(),
+                                            &bytes_read) &&
+                          bytes_read == m_cache.size();
+
+            ScanCounters work;
+            FREUD_STAT(work.bytes_requested = m_cache.size());
+            FREUD_STAT(work.bytes_read = bytes_read);
+            FREUD_STAT(work.read_calls = 1);
+            FREUD_STAT(work.failed_reads = result ? 0 : 1);
+            FREUD_STAT(m_read_counters.add(work));
+            if (!result) {
+                m_cache.resize(0);
+                return false;
+            }
+        }
+
+        address_t offset = address - m_cached_region.start_address;
+        data = m_cache.data() + offset;
+        available = m_cache.size() - offset;
+        return true;
+    }
+
     void update_regions() {
-        m_regions.clear();
+        std::vector<MemoryRegion> regions;
+        m_cache.clear();
         MEMORY_BASIC_INFORMATION mem_info;
         SYSTEM_INFO system_info;
         m_proc_handle = OpenProcess(PROCESS_ALL_ACCESS, TRUE, m_pid);
@@ -49,14 +109,38 @@ public:
 
             MemoryRegion region = {"", (address_t)mem_info.BaseAddress,
                                    (address_t)mem_info.BaseAddress +
-                                       mem_info.RegionSize};
-            m_regions.push_back(region);
+                                       mem_info.RegionSize,
+                                   permissions(mem_info.Protect), 0, 0};
+            regions.push_back(region);
         }
+        publish_regions(regions);
     }
 
 private:
+    /// Convert a page protection to RegionPermission flags
+    static unsigned permissions(DWORD protect) {
+        if (protect & (PAGE_NOACCESS | PAGE_GUARD)) {
+            return 0;
+        }
+        unsigned result = REGION_READ;
+        if (protect & (PAGE_READWRITE | PAGE_WRITECOPY |
+                       PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) {
+            result |= REGION_WRITE;
+        }
+        if (protect & (PAGE_EXECUTE | PAGE_EXECUTE_READ |
+                       PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)) {
+            result |= REGION_EXECUTE;
+        }
+        if (protect == PAGE_EXECUTE) {
+            result &= ~REGION_READ;
+        }
+        return result;
+    }
+
     unsigned long m_pid;
     HANDLE m_proc_handle;
+    MemoryRegion m_cached_region;
+    detail::AlignedBuffer m_cache;
 };
 
 typedef WindowsMemoryContext MemoryContext;
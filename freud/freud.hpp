@@ -5,8 +5,22 @@
 namespace freud {}
 
 #include "freud/HelperFunctions.hpp"
+#include "freud/MatchTracker.hpp"
 #include "freud/MemoryContext.hpp"
 #include "freud/MemoryContextIterator.hpp"
 #include "freud/MemoryObject.hpp"
 
+#if defined __gnu_linux__
+#include "freud/HeapScanner.hpp"
+#include "freud/IncrementalScanner.hpp"
+#include "freud/LocalMemoryContext.hpp"
+#include "freud/MultiProcessScanner.hpp"
+#include "freud/MultiScanner.hpp"
+#include "freud/NeedleScanner.hpp"
+#include "freud/PointerIndex.hpp"
+#include "freud/SnapshotMemoryContext.hpp"
+#include "freud/StringScanner.hpp"
+#include "freud/ValueScanner.hpp"
+#endif
+
 #endif